@@ -0,0 +1,134 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/19 上午9:40
+*/
+#ifndef WEBSERVER_BUFFER_H
+#define WEBSERVER_BUFFER_H
+
+/*Linux system APIS*/
+#include <sys/types.h>
+
+/*STD Headers*/
+#include <vector>
+#include <string_view>
+#include <cstring>
+#include <cassert>
+
+/*!
+@brief 连续内存的读写缓冲区，参考muduo的Buffer。
+
++-------------------+------------------+------------------+
+| prependable bytes |  readable bytes  |  writable bytes  |
+|                   |     (CONTENT)    |                  |
++-------------------+------------------+------------------+
+0      <=      reader_index_   <=   writer_index_    <=     size
+
+读出数据只移动reader_index_，不搬移内存；数据全部读完后两个下标复位。空间不足时优先把
+可读数据挪到前面，仍然不够才扩容，因此长连接稳定运行后不会再重新分配内存。
+*/
+class Buffer {
+public:
+    static const size_t kCheapPrepend = 8;           //预留在头部的空间
+    static const size_t kInitialSize = 1024;         //初始的可写空间
+    static const size_t kExtraBufferSize = 65536;    //ReadFd时栈上额外空间的大小
+private:
+    std::vector<char> buffer_;
+    size_t reader_index_;
+    size_t writer_index_;
+public:
+    explicit Buffer(size_t initial_size = kInitialSize)
+        : buffer_(kCheapPrepend + initial_size),
+          reader_index_(kCheapPrepend),
+          writer_index_(kCheapPrepend) {}
+
+    size_t ReadableBytes() const    {return writer_index_ - reader_index_;}
+    size_t WritableBytes() const    {return buffer_.size() - writer_index_;}
+    size_t PrependableBytes() const {return reader_index_;}
+
+    /*!
+    @brief 可读数据的首地址。注意，写入数据后该地址可能失效。
+    */
+    const char* Peek() const        {return buffer_.data() + reader_index_;}
+    std::string_view View() const   {return {Peek(), ReadableBytes()};}
+
+    /*!
+    @brief 删除前n个字节的可读数据。
+    */
+    void Retrieve(size_t n)
+    {
+        assert(n <= ReadableBytes());
+        if(n < ReadableBytes()) reader_index_ += n;
+        else RetrieveAll();
+    }
+
+    /*!
+    @brief 删除所有可读数据，下标复位。
+    */
+    void RetrieveAll()
+    {
+        reader_index_ = kCheapPrepend;
+        writer_index_ = kCheapPrepend;
+    }
+
+    /*!
+    @brief 追加数据。
+    */
+    void Append(const char* data, size_t n)
+    {
+        EnsureWritableBytes(n);
+        memcpy(BeginWrite(), data, n);
+        HasWritten(n);
+    }
+    void Append(std::string_view data) {Append(data.data(), data.size());}
+
+    /*!
+    @brief 在可读数据之前插入数据，n不能超过PrependableBytes()。
+    */
+    void Prepend(const void* data, size_t n)
+    {
+        assert(n <= PrependableBytes());
+        reader_index_ -= n;
+        memcpy(buffer_.data() + reader_index_, data, n);
+    }
+
+    /*!
+    @brief 保证至少有n个字节的可写空间。
+    */
+    void EnsureWritableBytes(size_t n)
+    {
+        if(WritableBytes() < n) MakeSpace(n);
+    }
+
+    /*!
+    @brief 可写空间的首地址，直接写入后需调用HasWritten。
+    */
+    char* BeginWrite() {return buffer_.data() + writer_index_;}
+    void HasWritten(size_t n)
+    {
+        assert(n <= WritableBytes());
+        writer_index_ += n;
+    }
+
+    /*!
+    @brief 释放多余的内存，只保留可读数据以及reserve个字节的可写空间。
+    */
+    void Shrink(size_t reserve);
+
+    /*!
+    @brief 调用一次readv从文件描述符读取数据。
+
+    除了缓冲区自身的可写空间之外，还会读到栈上kExtraBufferSize大小的额外空间中，读到的数据超出
+    可写空间时再追加到缓冲区。这样既不用预先分配很大的缓冲区，一次系统调用读到的数据也足够多。
+    @param[in]  fd          文件描述符。
+    @param[out] saved_errno 出错时的errno。
+    @return     readv的返回值。
+    */
+    ssize_t ReadFd(int fd, int* saved_errno);
+private:
+    /*!
+    @brief 空间不足时，先尝试把可读数据挪到头部，仍然不够才扩容。
+    */
+    void MakeSpace(size_t n);
+};
+
+#endif //WEBSERVER_BUFFER_H
@@ -15,6 +15,9 @@
 #include <iostream>
 #include <memory>
 
+/*User-define Headers*/
+#include "Poller.h"
+
 /*!
 @brief Channel类，即一个底层事件类。
 */
@@ -33,12 +36,22 @@ private:
     CallBack write_handler_;        //EPOLLOUT的回调函数
     CallBack error_handler_;        //EPOLLERR的回调函数
     CallBack disconn_handler_;      //EPOLLRDHUP的回调函数
+    std::function<void(int)> accept_handler_;              //kAccept的回调函数，参数为连接socket或-errno
+    std::function<void(const char*, int)> recv_handler_;   //kRecv的回调函数，参数为数据及其长度或-errno
+    std::function<void(int)> send_handler_;                //kSend的回调函数，参数为写出的字节数或-errno
 
     HttpData* p_holder_{};          //只有连接socket才需要一个holder，监听socket不需要
 public:
+    Channel() : Channel(-1, false) {}
     Channel(int fd, bool is_connfd);
     ~Channel();
 
+    /*!
+    @brief 供ObjectPool使用：Reuse代替构造函数，Recycle关闭文件描述符并清空回调函数。
+    */
+    void Reuse(int fd, bool is_connfd);
+    void Recycle();
+
     /*!
     @brief set and get fd_.
     */
@@ -76,12 +89,20 @@ public:
     void SetWriteHandler(CallBack write_handler)     { write_handler_ = std::move(write_handler);}
     void SetErrorHandler(CallBack error_handler)     { error_handler_ = std::move(error_handler);}
     void SetDisconnHandler(CallBack disconn_handler) { disconn_handler_ = std::move(disconn_handler);}
+    void SetAcceptHandler(std::function<void(int)> accept_handler)             { accept_handler_ = std::move(accept_handler);}
+    void SetRecvHandler(std::function<void(const char*, int)> recv_handler)    { recv_handler_ = std::move(recv_handler);}
+    void SetSendHandler(std::function<void(int)> send_handler)                 { send_handler_ = std::move(send_handler);}
 
     /*!
     @brief 根据revents_调用相应的回调函数。
     */
     void CallReventsHandlers();
 
+    /*!
+    @brief 根据完成事件的类型调用相应的回调函数，只用于支持异步I/O的Poller。
+    */
+    void CallCompletionHandler(const ReadyEvent& event);
+
     /*!
     @brief 判断channel的事件是否修改过并更新last_events。
     */
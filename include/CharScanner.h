@@ -0,0 +1,44 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/18 下午2:20
+*/
+#ifndef WEBSERVER_CHARSCANNER_H
+#define WEBSERVER_CHARSCANNER_H
+
+/*STD Headers*/
+#include <cstddef>
+#include <string_view>
+
+/*!
+@brief 请求报文解析时使用的字符扫描函数。
+
+运行时根据CPU支持的指令集选择AVX2、SSE4.2或者标量实现，一次检查16~32个字节。
+各函数均返回[p, p + n)中第一个不满足条件的字符的位置，所有字符都满足条件时返回n。
+*/
+
+/*!
+@brief 扫描tchar(方法字段、首部字段名中允许出现的字符)，通常停在空格或冒号处。
+*/
+size_t ScanTokenChars(const char* p, size_t n);
+
+/*!
+@brief 扫描URI中允许出现的字符，停在空格、控制字符或DEL处。
+*/
+size_t ScanUriChars(const char* p, size_t n);
+
+/*!
+@brief 扫描首部字段值中允许出现的字符，停在控制字符(水平制表符除外)或DEL处，通常即行尾的\r。
+*/
+size_t ScanFieldValueChars(const char* p, size_t n);
+
+/*!
+@brief 返回当前使用的实现的名字："avx2"、"sse4.2"或"scalar"。
+*/
+const char* CharScannerName();
+
+/*!
+@brief 指定使用的实现，CPU不支持时返回false且不做修改。仅用于测试，须在服务器启动前调用。
+*/
+bool SelectCharScanner(std::string_view name);
+
+#endif //WEBSERVER_CHARSCANNER_H
@@ -0,0 +1,132 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/21 下午4:10
+*/
+#ifndef WEBSERVER_COMPRESSIONCACHE_H
+#define WEBSERVER_COMPRESSIONCACHE_H
+
+/*STD Headers*/
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+#include "StaticCache.h"
+#include "Utility.h"
+
+/*!
+@brief 服务器支持的内容编码。
+*/
+enum class ContentCoding : uint8_t{
+    kIdentity = 0,
+    kGzip = 1 << 0,
+    kBrotli = 1 << 1,
+};
+
+/*!
+@brief 解析Accept-Encoding，返回客户端可以接受的gzip和br编码的位集合，q=0表示不可接受。
+*/
+unsigned ParseAcceptEncoding(std::string_view value);
+
+/*!
+@brief 判断该类型的文件是否值得压缩，图片、音视频等已经压缩过的格式不再压缩。
+*/
+bool IsCompressibleType(std::string_view content_type);
+
+/*!
+@brief 压缩的数据来源，与HttpData中的实体来源相同：内存中的数据或打开的文件。
+*/
+struct CompressSource{
+    std::shared_ptr<const void> holder;          //保持data或fd有效
+    const char* data;                            //内存中的数据，nullptr表示从fd读取
+    int fd;
+    off_t size;
+    std::string content_type;
+    FileValidators validators;                   //原始文件的验证器
+};
+
+/*!
+@brief 编码后的文件的缓存，所有SubReactor共用。
+
+保存两种内容：
+- 运行时用gzip压缩的文件，body为压缩后的数据。
+- 预压缩的.gz或.br文件的首部行，body为空，实体从FileCache中的文件发送。
+
+缓存的每一项都记录了来源文件的ETag，来源文件变化后自动失效。总内存不超过
+GlobalVar::compress_cache_budget_，按LRU淘汰。不值得压缩的文件(压缩率很低)也会被记录，
+避免重复压缩。
+
+所有文件都交给后台线程压缩，压缩完成前先返回未压缩的实体，Reactor线程中不做任何deflate。
+*/
+class CompressionCache : private NonCopyable {
+public:
+    static const size_t kMaxCompressSize = 8 * 1024 * 1024;     //运行时压缩的最大文件
+    static const size_t kMinCompressSize = 256;                 //太小的文件压缩后节省不了多少
+private:
+    struct Node{
+        std::string key;
+        std::string source_etag;                 //来源文件的ETag
+        std::shared_ptr<const CachedFile> file;  //nullptr表示不值得压缩
+        size_t charge;
+    };
+
+    std::mutex mutex_;
+    std::list<Node> lru_;
+    std::unordered_map<std::string_view, std::list<Node>::iterator> index_;
+    std::unordered_set<std::string> pending_;    //正在后台压缩的文件
+    size_t usage_ = 0;
+    size_t budget_;
+    ThreadPool worker_{1};                       //后台压缩线程
+public:
+    static CompressionCache& Instance();
+
+    /*!
+    @brief 查找name对应的gzip压缩文件。
+
+    @return std::nullopt表示缓存中没有或来源文件已变化，nullptr表示不值得压缩。
+    */
+    std::optional<std::shared_ptr<const CachedFile>> GetGzip(std::string_view name, const std::string& source_etag);
+
+    /*!
+    @brief 把文件交给后台线程压缩，立即返回。压缩结果放入缓存，之后由GetGzip取得。
+
+    同一个文件正在压缩时不重复提交。太小或太大的文件不压缩。
+    */
+    void CompressGzip(std::string_view name, CompressSource source);
+
+    /*!
+    @brief 获取预压缩文件对应的首部行，body为空。
+
+    @param[in] name          原始文件名。
+    @param[in] coding        预压缩文件的编码。
+    @param[in] compressed    预压缩文件。
+    @param[in] content_type  原始文件的类型。
+    */
+    std::shared_ptr<const CachedFile> GetPrecompressed(std::string_view name, ContentCoding coding,
+                                                        const OpenFile& compressed, const std::string& content_type);
+private:
+    explicit CompressionCache(size_t budget) : budget_(budget) {}
+
+    /*!
+    @brief 压缩数据，压缩后没有明显变小时返回nullptr。在后台线程中执行时不持有锁。
+    */
+    static std::shared_ptr<const CachedFile> Compress(const CompressSource& source);
+
+    /*!
+    @brief 生成缓存的键prefix + name。返回的是线程局部的缓冲区，下次调用时会被覆盖，查找时不需要分配内存。
+    */
+    static const std::string& MakeKey(std::string_view prefix, std::string_view name);
+
+    /*!
+    @brief 插入或替换key对应的项。需持有锁。
+    */
+    void Insert(const std::string& key, const std::string& source_etag, std::shared_ptr<const CachedFile> file);
+};
+
+#endif //WEBSERVER_COMPRESSIONCACHE_H
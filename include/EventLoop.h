@@ -5,36 +5,61 @@
 #ifndef WEBSERVER_EVENTLOOP_H
 #define WEBSERVER_EVENTLOOP_H
 
-/*Linux system APIS*/
-#include <sys/epoll.h>
-
 /*STL Headers*/
 #include <memory>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <functional>
+#include <thread>
 
 /*User-define Headers*/
 #include "Utility.h"
 #include "Timer.h"
+#include "MpscQueue.h"
+#include "ShardedCounter.h"
+#include "FdTable.h"
+#include "ObjectPool.h"
+#include "Poller.h"
 
 /*前向声明*/
 class Channel;
 class HttpData;
 
+/*!
+@brief 事件循环，one loop per thread。
+
+除RunInLoop、QueueInLoop、GetConnectionNum以及AddConnectionNum外，所有成员函数都只能在事件循环所在的线程中调用，
+其它线程需要通过RunInLoop把操作交给事件循环所在的线程执行，因此事件池和时间轮都不需要加锁。
+*/
 class EventLoop {
+public:
+    using Functor = std::function<void()>;
 private:
-    std::mutex mutex_for_conn_num_;                               //避免访问连接数量造成竞争
-    int connection_num_{};                                        //Reactor管理的http连接的数量
+    PaddedAtomic<int> connection_num_{};                          //分给该Reactor的http连接的数量(包括还在任务队列中的)，MainReactor分发连接时读取
 
     bool stop_ = false;                                                     //指示Sub/Main-Reactor是否工作，默认为正在工作
-    int epollfd_;                                                           //epoll内核事件表
+    std::unique_ptr<Poller> poller_;                                        //I/O多路复用后端，由GlobalVar::poller_backend_选择
+    bool async_io_;                                                         //poller_支持异步I/O：连接由accept/recv/sendmsg完成事件驱动
     static const int kMaxActiveEventNum = 4096;
-    static const int kEpollTimeOut = 10000;                                 //epoll超时时间10秒(单位为毫秒)
-    epoll_event active_events_[kMaxActiveEventNum];                         //就绪事件池
-    std::unique_ptr<Channel> events_channel_pool_[GlobalVar::kMaxUserNum];  //事件池
-    std::unique_ptr<HttpData> http_data_pool_[GlobalVar::kMaxUserNum];      //每一个连接socket的Channel都会对应一个HttpData对象
+    static const int kPollTimeOut = 10000;                                  //Poll超时时间10秒(单位为毫秒)
+    std::vector<ReadyEvent> active_events_;                                 //就绪事件池
+    FdTable<PoolPtr<Channel>> events_channel_pool_;                         //事件池，按需增长，释放的Channel放回对象池
+    FdTable<PoolPtr<HttpData>> http_data_pool_;                             //每一个连接socket的Channel都会对应一个HttpData对象
 
     bool is_main_reactor_;                                        //指示是否为MainReactor
+
+    std::atomic<std::thread::id> thread_id_{};                    //事件循环所在的线程，StartLoop之前为空
+    int wakeup_fd_;                                               //用于唤醒Poll的eventfd
+    MpscQueue<Functor> pending_functors_;                         //其它线程交给本线程执行的任务
+    std::atomic<bool> wakeup_pending_{false};                     //已经写过eventfd且任务还未执行，不必重复唤醒
+    int tick_fd_ = -1;                                            //驱动时间轮的timerfd，每GlobalVar::slot_interval_触发一次，async_io_时不使用
+    static const int kMaxPendingFunctorNum = 1024;                //每次Poll返回后最多执行的任务数
+
+    static constexpr std::chrono::milliseconds kBusyTimeWindow{1000};   //统计忙碌时间的周期，与tick间隔无关
+    uint64_t busy_ns_ = 0;                                        //本周期内处理事件和任务的时间
+    std::chrono::milliseconds busy_window_elapsed_{0};            //本周期已经经过的时间，按tick累加
+    PaddedAtomic<uint64_t> recent_busy_ns_{};                     //最近几个周期忙碌时间的指数加权平均，负载均衡时读取
 public:
     TimeWheel timewheel_;                                         //为了避免竞争，让每个事件池都拥有一个独立的时间轮
 public:
@@ -44,13 +69,40 @@ public:
     /*!
     @brief 添加新的监听对象。
 
-    如果添加的监听对象是连接socket，那么该函数会对其holder设置并挂靠一个定时器。
+    如果添加的监听对象是连接socket，那么该函数会对其holder设置并挂靠一个定时器。连接数已在分发时由
+    AddConnectionNum计入，这里不再修改。
     定时器的超时时间默认为GlobalVar::client_header_timeout_。
     @param[in] event_channel 监听对象。
     @param[in] timeout       超时时间。
     @return    true添加成功，false添加失败。
     */
-    bool AddEpollEvent(Channel* event_channel, std::chrono::seconds timeout = GlobalVar::client_header_timeout_);
+    bool AddEpollEvent(Channel* event_channel, std::chrono::milliseconds timeout = GlobalVar::client_header_timeout_);
+
+    /*!
+    @brief 用multishot accept监听listen_channel，新连接交给它的accept回调函数。
+
+    @return false表示Poller不支持异步I/O或注册失败，此时应改用AddEpollEvent。
+    */
+    bool AddAcceptor(Channel* listen_channel);
+
+    /*!
+    @brief 提交sendmsg，完成时调用event_channel的send回调函数。msg及其指向的数据在完成之前必须保持有效，
+    也不能在完成之前删除event_channel。
+
+    @return false表示Poller不支持异步I/O或提交失败。
+    */
+    bool SendAsync(Channel* event_channel, const msghdr* msg, int flags);
+
+    /*!
+    @brief 暂停或恢复连接socket上的recv，不支持异步I/O时什么也不做。
+    */
+    void PauseRecv(Channel* event_channel);
+    void ResumeRecv(Channel* event_channel);
+
+    /*!
+    @brief Poller是否支持异步I/O。支持时连接socket的数据由recv回调函数送达，而不是EPOLLIN。
+    */
+    bool IsAsyncIo() const {return async_io_;}
 
     /*!
     @brief 修改监听对象所要监听的事件。
@@ -81,17 +133,80 @@ public:
     /*!
     @brief 返回连接数量。
     */
-    int GetConnectionNum();
+    int GetConnectionNum() const {return connection_num_.Load();}
+
+    /*!
+    @brief 修改连接数量，任意线程都可以调用。
+
+    连接在分发时(RunInLoop之前)就计入目标Reactor，否则一次accept的连接在SubReactor执行任务之前
+    都看不到，按连接数选择的分发策略会把它们都分给同一个SubReactor。连接加入事件池失败时减回去，
+    关闭连接时由DelEpollEvent减一。
+    */
+    void AddConnectionNum(int n) {connection_num_.Add(n);}
 
     /*!
-    @brief 返回epoll内核事件表文件描述符。
+    @brief 在事件循环所在的线程中执行func。
+
+    在事件循环所在的线程中调用时直接执行，否则交给QueueInLoop。
     */
-    [[maybe_unused]]int GetEpollfd(){return epollfd_;}
+    void RunInLoop(Functor func);
+
+    /*!
+    @brief 将func放入任务队列，由事件循环所在的线程在Poll返回后执行，任意线程都可以调用。
+    */
+    void QueueInLoop(Functor func);
+
+    /*!
+    @brief 判断当前线程是否为事件循环所在的线程。
+    */
+    bool IsInLoopThread() const {return thread_id_.load(std::memory_order_acquire) == std::this_thread::get_id();}
+
+    /*!
+    @brief 结束一个统计周期，把本周期的忙碌时间计入recent_busy_ns_。
+
+    每个tick累加经过的时间，满kBusyTimeWindow时调用，因此周期长度不随tick间隔变化。
+    */
+    void UpdateBusyTime();
+
+    /*!
+    @brief 返回最近每个周期的平均忙碌时间(纳秒)，任意线程都可以调用。
+    */
+    uint64_t GetRecentBusyTime() const {return recent_busy_ns_.Load();}
+
+    /*!
+    @brief 返回使用的I/O多路复用后端的名字。
+    */
+    const char* GetPollerName() const {return poller_->Name();}
 private:
     /*!
-    @brief 调用epoll_wait并根据事件调用其响应函数
+    @brief 调用Poll并根据事件调用其响应函数
     */
     void GetActiveEventsAndProc();
+
+    /*!
+    @brief 写wakeup_fd_唤醒Poll。
+    */
+    void Wakeup();
+
+    /*!
+    @brief wakeup_fd_的EPOLLIN回调函数，读出计数器以便下一次写入时再次触发。
+    */
+    void WakeupHandler();
+
+    /*!
+    @brief tick_fd_的EPOLLIN回调函数，读出到期次数后交给AdvanceTimeWheel。
+    */
+    void TickHandler();
+
+    /*!
+    @brief 按到期次数转动时间轮，同时刷新Date首部行并统计忙碌时间。
+    */
+    void AdvanceTimeWheel(uint64_t expirations);
+
+    /*!
+    @brief 执行任务队列中的任务，一次最多执行kMaxPendingFunctorNum个，剩下的留给下一轮循环。
+    */
+    void DoPendingFunctors();
 };
 
 #endif //WEBSERVER_EVENTLOOP_H
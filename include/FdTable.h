@@ -0,0 +1,73 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/24 上午10:15
+*/
+#ifndef WEBSERVER_FDTABLE_H
+#define WEBSERVER_FDTABLE_H
+
+/*STD Headers*/
+#include <array>
+#include <memory>
+#include <vector>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+
+/*!
+@brief 以文件描述符为下标的表，按块分配。
+
+文件描述符是整个进程共用的，每个EventLoop只会用到其中一部分。表按kChunkSize个元素一块，只有块中
+有文件描述符被用到时才分配，内存占用随实际使用的文件描述符增长，文件描述符的大小也没有上限。
+块一旦分配就不会移动或释放，因此返回的引用在表析构之前一直有效，即使之后表又增长了。
+*/
+template<typename T>
+class FdTable : private NonCopyable {
+public:
+    static constexpr size_t kChunkBits = 8;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;    //每块256个元素
+private:
+    using Chunk = std::array<T, kChunkSize>;
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+public:
+    FdTable() = default;
+
+    /*!
+    @brief 返回fd对应的元素，所在的块不存在时先分配。fd不能为负数。
+    */
+    T& operator[](int fd)
+    {
+        auto index = static_cast<size_t>(fd);
+        auto chunk_index = index >> kChunkBits;
+        if(chunk_index >= chunks_.size()) chunks_.resize(chunk_index + 1);
+        auto& chunk = chunks_[chunk_index];
+        if(!chunk) chunk = std::make_unique<Chunk>();
+        return (*chunk)[index & (kChunkSize - 1)];
+    }
+
+    /*!
+    @brief 查找fd对应的元素，所在的块还未分配时返回nullptr，不会分配内存。
+    */
+    T* Find(int fd)
+    {
+        auto index = static_cast<size_t>(fd);
+        auto chunk_index = index >> kChunkBits;
+        if(fd < 0 || chunk_index >= chunks_.size() || !chunks_[chunk_index]) return nullptr;
+        return &(*chunks_[chunk_index])[index & (kChunkSize - 1)];
+    }
+    const T* Find(int fd) const {return const_cast<FdTable*>(this)->Find(fd);}
+
+    /*!
+    @brief 按文件描述符从小到大遍历已分配的块中的所有元素。
+    */
+    template<typename F>
+    void ForEach(F&& func)
+    {
+        for (size_t i = 0; i < chunks_.size(); ++i)
+        {
+            if(!chunks_[i]) continue;
+            for (auto& item : *chunks_[i]) func(item);
+        }
+    }
+};
+
+#endif //WEBSERVER_FDTABLE_H
@@ -0,0 +1,136 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/20 下午3:40
+*/
+#ifndef WEBSERVER_FILECACHE_H
+#define WEBSERVER_FILECACHE_H
+
+/*Linux system APIS*/
+#include <sys/stat.h>
+
+/*STD Headers*/
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+#include "Utility.h"
+
+/*!
+@brief 文件的验证器，用于处理条件请求。
+
+ETag由inode、大小以及纳秒级的修改时间哈希而成，文件的每个版本只计算一次。
+*/
+struct FileValidators{
+    std::string etag;                            //强ETag，含双引号
+    time_t last_modified = 0;
+    std::string header;                          //渲染好的ETag和Last-Modified首部行
+
+    /*!
+    @brief 根据stat得到的信息生成验证器。
+    */
+    static FileValidators FromStat(const struct stat& st);
+};
+
+/*!
+@brief 已打开的资源文件及其元数据。
+
+header为渲染好的Content-Type、Content-Length、Accept-Ranges以及验证器首部行(含结尾的空行)。fd可能同时被多个连接使用，
+读取时必须用pread或带偏移量的sendfile，不能改变文件偏移量。
+*/
+struct OpenFile{
+    FileDescriptor fd;
+    off_t size = 0;
+    ino_t ino = 0;
+    timespec mtime{};
+    std::string content_type;
+    FileValidators validators;
+    std::string header;
+
+    explicit OpenFile(int file_fd) : fd(file_fd) {}
+
+    /*!
+    @brief 判断stat得到的信息与缓存时的文件是否为同一个版本。
+    */
+    bool SameVersion(const struct stat& st) const
+    {
+        return st.st_ino == ino && st.st_size == size &&
+               st.st_mtim.tv_sec == mtime.tv_sec && st.st_mtim.tv_nsec == mtime.tv_nsec;
+    }
+};
+
+/*!
+@brief 资源文件的文件描述符及元数据缓存，参考nginx的open_file_cache，所有SubReactor共用。
+
+- 缓存最近使用的文件的fd、大小、修改时间以及渲染好的首部行，命中时省去stat、open和close。
+- 惰性验证：距上次验证超过GlobalVar::open_file_cache_valid_时才重新stat一次，文件未变化则继续使用，
+  否则重新打开。资源目录的inotify事件也会使对应的缓存失效。
+- 超过GlobalVar::open_file_cache_inactive_未被使用的文件在插入新文件时被淘汰，文件数量超过上限时
+  淘汰最久未使用的文件。
+- 文件以shared_ptr的形式交给调用者，被淘汰时正在发送的文件不会被关闭。
+- 不存在的文件同样会被缓存(file为nullptr)，并按同样的规则重新验证。
+*/
+class FileCache : private NonCopyable {
+public:
+    static const size_t kShardNum = 16;
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Node{
+        std::string key;
+        std::shared_ptr<const OpenFile> file;    //nullptr表示文件不存在
+        Clock::time_point validated;             //上次验证的时间
+        Clock::time_point last_used;             //上次使用的时间
+    };
+
+    struct Shard{
+        std::mutex mutex;
+        std::list<Node> lru;                     //表头为最近使用的文件
+        std::unordered_map<std::string_view, std::list<Node>::iterator> index;
+    };
+
+    size_t shard_capacity_;                      //每个分片最多缓存的文件数，0表示不使用缓存
+    std::vector<std::unique_ptr<Shard>> shards_;
+public:
+    /*!
+    @brief 全局唯一的缓存对象，首次调用时按GlobalVar::open_file_cache_max_初始化。
+    */
+    static FileCache& Instance();
+
+    /*!
+    @brief 获取资源目录下名为name的文件，文件不存在或不是普通文件时返回nullptr。
+    */
+    std::shared_ptr<const OpenFile> Get(std::string_view name);
+
+    /*!
+    @brief 使name对应的缓存失效。
+    */
+    void Invalidate(std::string_view name);
+
+    /*!
+    @brief 清空所有缓存。
+    */
+    void Clear();
+private:
+    explicit FileCache(size_t capacity);
+
+    Shard& ShardOf(std::string_view name) {return *shards_[std::hash<std::string_view>{}(name) % kShardNum];}
+
+    /*!
+    @brief 打开文件并生成OpenFile对象，失败时返回nullptr。
+    */
+    static std::shared_ptr<const OpenFile> Open(std::string_view name);
+
+    /*!
+    @brief 插入或替换name对应的文件。需持有分片的锁。
+    */
+    void Insert(Shard& shard, std::string_view name, std::shared_ptr<const OpenFile> file, Clock::time_point now);
+};
+
+#endif //WEBSERVER_FILECACHE_H
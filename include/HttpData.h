@@ -10,8 +10,19 @@
 #include <unordered_map>
 #include <thread>
 #include <mutex>
-#include <map>
-#include <functional>
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+
+/*User-define Headers*/
+#include "HttpParser.h"
+#include "Buffer.h"
+#include "OutputQueue.h"
+#include "FileCache.h"
+#include "HttpRange.h"
+#include "HttpResponse.h"
+#include "Timer.h"
 
 /*!
 @brief 表示请求报文解析状态的枚举。
@@ -25,24 +36,6 @@ enum class RequestMsgParseState{
     kFinish,
 };
 
-/*!
-@brief 表示http请求报文中请求行解析状态的枚举。
-*/
-enum class RequestLineParseState{
-    kParseAgain,
-    kParseError,
-    kParseSuccess,
-};
-
-/*!
-@brief 表示http请求报文中首部行解析状态的枚举。
-*/
-enum class HeaderLinesParseState{
-    kParseAgain,
-    kParseError,
-    kParseSuccess,
-};
-
 /*!
 @brief 表示请求报文分析状态的枚举。
 */
@@ -58,33 +51,62 @@ enum class RequestMsgAnalysisState{
 /*前向声明*/
 class EventLoop;
 class Channel;
-class Timer;
 
 class HttpData {
 private:
-    Channel* p_connfd_channel_;                            //连接socket对应的Channel对象的智能指针
-    EventLoop* p_sub_reactor_;                             //connfd_channel_属于的SubReactor
-    Timer* p_timer_{};                                     //挂靠的定时器
-
-    std::string read_in_buffer_{};                         //http请求报文
-    std::string write_out_buffer_{};                       //http响应报文
-    RequestMsgParseState request_msg_parse_state_;         //表示请求报文的解析状态
-    std::map<std::string,std::string> fields_values_{};    //请求报文字段与其对应的值
-    std::map<std::string,std::function<RequestMsgAnalysisState()>> method_proc_func_;  //请求报文中方法字段与业务处理函数的映射
+    Channel* p_connfd_channel_{};                          //连接socket对应的Channel对象的智能指针
+    EventLoop* p_sub_reactor_{};                          //connfd_channel_属于的SubReactor
+    Timer timer_{[this](){ExpiredHandler();}};             //连接的定时器，随对象一起复用
+
+    Buffer read_in_buffer_{};                              //http请求报文
+    OutputQueue write_out_queue_{};                        //http响应报文
+    RequestMsgParseState request_msg_parse_state_{};       //表示请求报文的解析状态
+    HttpRequestParser parser_{};                           //请求报文解析器，保存各字段在read_in_buffer_中的位置
+    size_t request_msg_size_ = 0;                          //当前请求报文(含实体)的总字节数，用于管线化请求
+    bool keep_alive_ = false;                              //响应报文发送完后是否保持连接
+
+    /*!
+        Poller支持异步I/O时，请求报文由recv回调函数送达，响应报文中的内存段用异步的sendmsg发送。
+        sendmsg完成之前输出队列不能修改，期间到达的请求报文只放进读缓冲区，积压太多时暂停recv。
+     */
+    bool async_io_ = false;
+    bool send_inflight_ = false;                           //sendmsg已提交还未完成
+    bool recv_paused_ = false;
+    bool peer_closed_ = false;                             //对端已关闭连接，当前响应报文发送完后断开
+    bool disconnect_pending_ = false;                      //sendmsg完成后断开连接
+    msghdr send_msg_{};
+    std::array<iovec, OutputQueue::kMaxIovecNum> send_iov_{};
+    static const size_t kMaxPendingInputSize = 64 * 1024;  //响应报文发送完之前最多缓存的输入，超过时暂停recv
+
+    /*!
+        处理一个请求时的临时字符串和数组(文件名、Range区间、multipart首部、POST实体等)都从arena_分配，
+        请求处理完后在Reset中整体释放。初始块是对象的一部分，随对象池一起复用，一般的请求不需要
+        访问堆；初始块不够时才向堆申请更多内存，同样在Reset时释放。
+     */
+    static const size_t kArenaSize = 4096;
+    alignas(std::max_align_t) std::array<std::byte, kArenaSize> arena_block_{};
+    std::pmr::monotonic_buffer_resource arena_{arena_block_.data(), arena_block_.size()};
+
+    static const size_t kMaxPooledBufferSize = 64 * 1024;  //放回对象池时超过该大小的读缓冲区会被缩小
 public:
     HttpData() = default;
     HttpData(EventLoop* sub_reactor,Channel* connfd_channel);
     ~HttpData();
 
     /*!
-    @brief 挂靠定时器并设置超时回调函数
+    @brief 供ObjectPool使用，代替构造函数。缓冲区中的数据已在Recycle中清空，但保留已分配的内存。
     */
-    void LinkTimer(Timer* p_timer);
+    void Reuse(EventLoop* sub_reactor,Channel* connfd_channel);
 
     /*!
-    @brief 获取挂靠的定时器，不要delete返回的指针
+    @brief 供ObjectPool使用，清空连接状态和缓冲区，释放响应报文持有的文件和缓存。
     */
-    Timer* GetTimer() {return p_timer_;}
+    void Recycle();
+
+    /*!
+    @brief 获取连接的定时器，由所在SubReactor的时间轮调度，不要delete返回的指针
+    */
+    Timer* GetTimer() {return &timer_;}
 private:
     ///////////////////////////
     //       CallBacks       //
@@ -99,6 +121,21 @@ private:
     */
     void ReadHandler();
 
+    /*!
+    @brief recv完成事件的回调函数，异步I/O时代替ReadHandler。
+
+    @param[in] data  读到的数据，只在回调函数中有效。
+    @param[in] n     数据的长度，0表示对端关闭了连接，负数为-errno。
+    */
+    void RecvHandler(const char* data, int n);
+
+    /*!
+    @brief sendmsg完成事件的回调函数，删除写出的数据后继续发送剩余的响应报文。
+
+    @param[in] n  写出的字节数，负数为-errno。
+    */
+    void SendHandler(int n);
+
     /*!
     @brief EPOLLOUT的回调函数。
 
@@ -133,27 +170,12 @@ private:
     //////////////////////////////
 
     /*!
-    @brief 解析http请求报文的请求行。
-
-    请求行解析成功后，其方法字段、URI以及http协议版本会被存放在fields_values_中，
-    对应的key值分别为method URI以及version。
-    @return RequestLineParseState::kParseAgain   请求行数据不完整。
-    @return RequestLineParseState::kParseError   请求行数据完整但有语法错误。
-    @return RequestLineParseState::kParseSuccess 请求行解析成功。
-    */
-    RequestLineParseState ParseRequestLine();
-
-    /*!
-    @brief 解析http请求报文的首部行。
+    @brief 解析read_in_buffer_中的请求报文并发送响应报文。
 
-    首部行解析完成后，字段以及字段值将会存储在fields_values_中，索引即为字段本身
-    此函数只会判断首部行数据是否完整以及首部航是否存在格式错误。不对字段是否有效以
-    及字段的拼写是否正确做出判断。
-    @return HeaderLinesParseState::kParseAgain  首部行数据不完整。
-    @return HeaderLinesParseState::kParseError  首部行数据完整但格式不正确。
-    @return HeaderLinesParseState::kParseSucess 首部行解析成功。
+    根据报文的解析状态一层层的推进，数据不完整时返回等待下一波数据的到来。管线化的情况下，
+    一个响应报文发送完毕后会继续处理缓冲区中剩余的请求报文。
     */
-    HeaderLinesParseState ParseHeaderLines();
+    void ProcessRequestMsg();
 
     /*!
     @brief 分析请求报文并编写相应的响应报文。
@@ -177,6 +199,17 @@ private:
     */
     RequestMsgAnalysisState ProcessPOST();
 
+    /*!
+    @brief 请求方法与业务处理函数的映射，以HttpMethod为下标，所有连接共用。nullptr表示不支持该方法。
+    */
+    using ProcessFunc = RequestMsgAnalysisState (HttpData::*)();
+    static constexpr std::array<ProcessFunc, kHttpMethodNum> kMethodProcFuncs{
+        &HttpData::ProcessGETorHEAD,      //HttpMethod::kGet
+        &HttpData::ProcessGETorHEAD,      //HttpMethod::kHead
+        &HttpData::ProcessPOST,           //HttpMethod::kPost
+        nullptr,                          //HttpMethod::kUnknown
+    };
+
     ///////////////////////////
     //        Tools          //
     ///////////////////////////
@@ -184,11 +217,12 @@ private:
     /*!
     @brief 编写带错误代码和错误信息的响应报文。
 
+    错误页面是预先生成的，detail只写入日志。
     @param[in] fd         连接socket的文件描述符。
-    @param[in] error_num  http错误代码。
-    @param[in] msg        错误信息。
+    @param[in] status     http错误代码。
+    @param[in] detail     错误的详细信息。
     */
-    void SetHttpErrorMsg(int fd, int error_num, std::string msg);
+    void SetHttpErrorMsg(int fd, HttpStatus status, std::string_view detail);
 
     /*!
     @brief 互斥注册EPOLLIN和EPOLLOUT。
@@ -198,17 +232,86 @@ private:
     */
     void MutexRegInOrOut(bool epollin);
 
+    /*!
+    @brief 发送响应报文。
+
+    异步I/O时内存段以sendmsg提交，由SendHandler继续；文件段仍用sendfile发送。
+    @return true表示响应报文已全部发送且连接信息已重置，false表示还未发送完(已注册EPOLLOUT或已提交sendmsg)或连接已断开。
+    */
+    bool FlushResponseMsg();
+
     /*!
     @brief 还原http连接信息。
 
-    清除连接信息并根据keep-alive设置超时时间。
+    从read_in_buffer_中删除已处理的请求报文并根据keep-alive设置超时时间。
+    @return true表示连接仍然保持，false表示连接已断开。
+    */
+    bool Reset();
+
+    /*!
+    @brief 获取请求报文中常用首部字段的值，字段不存在时返回空的string_view。
     */
-    void Reset();
+    std::string_view GetHeader(HttpField field) {return parser_.Header(read_in_buffer_.Peek(), field);}
 
     /*!
     @brief 编写响应报文中和请求报文中的方法字段无关的内容。
+
+    状态行、Date、Server以及Connection字段都是渲染好的，只需拷贝，不分配内存。
+    @param[in] status  状态码。
+    */
+    void FillPartOfResponseMsg(HttpStatus status = HttpStatus::kOk);
+
+    /*!
+    @brief 静态文件响应的实体来源：静态文件缓存中的数据或FileCache中打开的文件。
+    */
+    struct FileBody{
+        std::shared_ptr<const void> holder;          //保持data或fd有效
+        const char* data;                            //内存中的实体，nullptr表示从fd发送
+        int fd;
+        off_t size;
+        const std::string& content_type;
+        const FileValidators& validators;
+        const std::string& header;                   //200响应的首部行(含结尾的空行)
+    };
+
+    /*!
+    @brief 根据Accept-Encoding选择静态文件的编码后再编写响应报文。
+
+    依次尝试预压缩的.br和.gz文件以及运行时gzip压缩的文件，都不可用时返回未压缩的实体。
+    */
+    RequestMsgAnalysisState ReplyFileWithEncoding(std::string_view file_name, const FileBody& body);
+
+    /*!
+    @brief 编写静态文件的响应报文，处理条件请求、HEAD方法以及Range请求。
+    */
+    RequestMsgAnalysisState ReplyFile(const FileBody& body);
+
+    /*!
+    @brief 将实体中从offset开始的n个字节追加到输出队列，不拷贝数据。
+    */
+    void AppendFileBody(const FileBody& body, off_t offset, size_t n);
+
+    /*!
+    @brief 判断If-Range是否满足，不存在If-Range时返回true。不满足时忽略Range返回整个实体。
+    */
+    bool IfRangeMatches(const FileValidators& validators);
+
+    /*!
+    @brief 编写206 Partial Content响应报文，多个区间时使用multipart/byteranges。
+    */
+    RequestMsgAnalysisState ReplyPartialContent(const FileBody& body, const std::pmr::vector<ByteRange>& ranges);
+
+    /*!
+    @brief 根据If-None-Match和If-Modified-Since判断客户端缓存的资源是否仍然有效。
+
+    If-None-Match存在时忽略If-Modified-Since。
+    */
+    bool IsNotModified(const FileValidators& validators);
+
+    /*!
+    @brief 编写304 Not Modified响应报文，只包含验证器首部行，没有实体。
     */
-    void FillPartOfResponseMsg();
+    RequestMsgAnalysisState ReplyNotModified(const FileValidators& validators);
 };
 
 /*!
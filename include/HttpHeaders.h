@@ -0,0 +1,125 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/18 下午4:05
+*/
+#ifndef WEBSERVER_HTTPHEADERS_H
+#define WEBSERVER_HTTPHEADERS_H
+
+/*STD Headers*/
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*!
+@brief 接收缓冲区中的一段数据，以相对于请求报文起始位置的偏移量表示。
+
+不直接保存指针是因为接收缓冲区在接收实体数据时可能会扩容，偏移量在扩容后依然有效。
+*/
+struct StrSpan{
+    size_t offset = 0;
+    size_t length = 0;
+
+    std::string_view View(const char* base) const {return {base + offset, length};}
+};
+
+/*!
+@brief 服务器关心的首部字段。
+*/
+enum class HttpField : uint8_t{
+    kAccept,
+    kAcceptEncoding,
+    kConnection,
+    kContentLength,
+    kContentType,
+    kCookie,
+    kHost,
+    kIfModifiedSince,
+    kIfNoneMatch,
+    kIfRange,
+    kKeepAlive,
+    kRange,
+    kTransferEncoding,
+    kUserAgent,
+    kUnknown,            //不在上面的字段
+};
+
+constexpr size_t kKnownFieldNum = static_cast<size_t>(HttpField::kUnknown);
+
+/*!
+@brief 各首部字段的标准写法，顺序与HttpField一致。
+*/
+constexpr std::array<std::string_view, kKnownFieldNum> kHttpFieldNames{
+    "Accept", "Accept-Encoding", "Connection", "Content-Length", "Content-Type", "Cookie", "Host",
+    "If-Modified-Since", "If-None-Match", "If-Range", "Keep-Alive", "Range", "Transfer-Encoding", "User-Agent",
+};
+
+/*!
+@brief 根据字段名(不区分大小写)获取对应的HttpField。
+
+使用编译期生成的完美哈希表：只对长度以及首、中、尾三个字符做哈希，一次查表加一次比较即可，
+不在表中的字段返回HttpField::kUnknown。
+*/
+HttpField LookupHttpField(std::string_view name);
+
+/*!
+@brief 不区分大小写地比较两个字符串是否相等。
+*/
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs);
+
+/*!
+@brief 请求报文的首部行。
+
+每个连接一个，只保存各首部行在接收缓冲区中的位置，使用定长数组不会分配内存。常用的字段在
+解析时就确定了其HttpField，查询时直接按下标读取。同名字段出现多次时以第一个为准。
+*/
+class HttpHeaderTable {
+public:
+    static const size_t kMaxFieldNum = 64;                     //一个请求报文中首部行的最大数量
+private:
+    struct Entry{
+        StrSpan name;
+        StrSpan value;
+    };
+    std::array<Entry, kMaxFieldNum> entries_{};                //按出现顺序保存的首部行
+    size_t size_ = 0;                                          //首部行的数量
+    std::array<uint8_t, kKnownFieldNum> known_{};              //常用字段在entries_中的下标加1，0表示不存在
+public:
+    /*!
+    @brief 添加一个首部行。
+
+    @param[in] name_view 字段名，用于确定其HttpField。
+    @return    false表示首部行数量超过了kMaxFieldNum。
+    */
+    bool Add(std::string_view name_view, StrSpan name, StrSpan value);
+
+    /*!
+    @brief 获取常用字段的值，字段不存在时返回空的string_view。
+    */
+    std::string_view Get(const char* base, HttpField field) const
+    {
+        auto index = known_[static_cast<size_t>(field)];
+        return index ? entries_[index - 1].value.View(base) : std::string_view{};
+    }
+
+    /*!
+    @brief 判断常用字段是否存在。
+    */
+    bool Has(HttpField field) const {return known_[static_cast<size_t>(field)] != 0;}
+
+    /*!
+    @brief 查找任意字段的值，字段名不区分大小写。
+    */
+    std::string_view Find(const char* base, std::string_view name) const;
+
+    /*!
+    @brief 清空所有首部行。
+    */
+    void Clear()
+    {
+        size_ = 0;
+        known_.fill(0);
+    }
+};
+
+#endif //WEBSERVER_HTTPHEADERS_H
@@ -0,0 +1,154 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/18 上午10:12
+*/
+#ifndef WEBSERVER_HTTPPARSER_H
+#define WEBSERVER_HTTPPARSER_H
+
+/*STD Headers*/
+#include <string_view>
+#include <cstddef>
+
+/*User-define Headers*/
+#include "HttpHeaders.h"
+
+/*!
+@brief 表示http请求报文中请求行解析状态的枚举。
+*/
+enum class RequestLineParseState{
+    kParseAgain,
+    kParseError,
+    kParseSuccess,
+};
+
+/*!
+@brief 表示http请求报文中首部行解析状态的枚举。
+*/
+enum class HeaderLinesParseState{
+    kParseAgain,
+    kParseError,
+    kParseSuccess,
+};
+
+/*!
+@brief 请求方法，kUnknown表示服务器不支持的方法。
+*/
+enum class HttpMethod : uint8_t{
+    kGet,
+    kHead,
+    kPost,
+    kUnknown,
+};
+
+constexpr size_t kHttpMethodNum = static_cast<size_t>(HttpMethod::kUnknown) + 1;
+
+/*!
+@brief 根据方法字段(区分大小写)获取对应的HttpMethod。
+*/
+HttpMethod ParseHttpMethod(std::string_view method);
+
+/*!
+@brief http请求报文解析器。
+
+增量式解析：不拷贝、不修改接收缓冲区，只记录方法、URI、协议版本以及各首部行在缓冲区中
+的位置。数据不完整时会保存扫描进度，下一次调用从上次停止的位置继续扫描，不会从头再来。
+字段边界的查找以及非法字符的检查由CharScanner.h中的向量化函数一次完成。
+*/
+class HttpRequestParser {
+private:
+    static const size_t kMaxRequestLineSize = 8 * 1024;        //请求行的最大长度
+    static const size_t kMaxHeaderSize = 64 * 1024;            //请求行加首部行的最大长度
+
+    /*!
+    @brief 当前行内的解析进度。
+    */
+    enum class LineState{
+        kLineStart,         //行首
+        kMethod,            //请求行的方法字段
+        kUri,               //请求行的URI
+        kVersion,           //请求行的协议版本
+        kFieldName,         //首部行的字段名
+        kFieldValue,        //首部行的字段值
+        kLineEnd,           //行尾的\r\n
+    };
+
+    LineState line_state_ = LineState::kLineStart;             //当前行内的解析进度
+    size_t line_start_ = 0;                                    //当前行的起始位置
+    size_t scan_pos_ = 0;                                      //当前行中已扫描到的位置，数据不完整时从这里继续
+    size_t field_start_ = 0;                                   //当前正在扫描的字段的起始位置
+    StrSpan field_name_{};                                     //当前首部行的字段名
+    size_t header_end_ = 0;                                    //空行之后，即实体数据的起始位置
+    StrSpan method_{};                                         //方法字段
+    HttpMethod method_type_ = HttpMethod::kUnknown;            //方法字段对应的HttpMethod
+    StrSpan uri_{};                                            //URI
+    StrSpan version_{};                                        //协议版本
+    HttpHeaderTable headers_{};                                //首部字段及其对应的值
+public:
+    HttpRequestParser() = default;
+
+    /*!
+    @brief 解析请求行。
+
+    请求行的格式为：方法|空格|URI|空格|协议版本|回车符|换行符。请求行之前的空行会被忽略。
+    @param[in] data 请求报文的首地址。
+    @param[in] len  目前接收到的请求报文的字节数。
+    @return RequestLineParseState::kParseAgain   请求行数据不完整。
+    @return RequestLineParseState::kParseError   请求行数据完整但有语法错误。
+    @return RequestLineParseState::kParseSuccess 请求行解析成功。
+    */
+    RequestLineParseState ParseRequestLine(const char* data, size_t len);
+
+    /*!
+    @brief 解析首部行，必须在请求行解析成功之后调用。
+
+    首部行的格式为：字段名|:|可选空白|字段值|可选空白|回车符|换行符。只检查格式，不对字段是否有效做出判断。
+    首部行的数量超过HttpHeaderTable::kMaxFieldNum时视为格式错误。
+    @param[in] data 请求报文的首地址。
+    @param[in] len  目前接收到的请求报文的字节数。
+    @return HeaderLinesParseState::kParseAgain   首部行数据不完整。
+    @return HeaderLinesParseState::kParseError   首部行数据完整但格式不正确。
+    @return HeaderLinesParseState::kParseSuccess 首部行解析成功。
+    */
+    HeaderLinesParseState ParseHeaderLines(const char* data, size_t len);
+
+    /*!
+    @brief 清空解析结果，准备解析下一个请求报文。
+    */
+    void Reset();
+
+    /*!
+    @brief 获取请求行中的各字段，base为请求报文的首地址。
+    */
+    std::string_view Method(const char* base) const  {return method_.View(base);}
+    std::string_view Uri(const char* base) const     {return uri_.View(base);}
+    std::string_view Version(const char* base) const {return version_.View(base);}
+
+    /*!
+    @brief 获取请求方法，在请求行解析成功后有效。
+    */
+    HttpMethod MethodType() const {return method_type_;}
+
+    /*!
+    @brief 获取常用首部字段的值，字段不存在时返回空的string_view。
+    */
+    std::string_view Header(const char* base, HttpField field) const {return headers_.Get(base, field);}
+
+    /*!
+    @brief 查找任意首部字段的值，字段名不区分大小写。字段不存在时返回空的string_view。
+    */
+    std::string_view FindHeader(const char* base, std::string_view name) const {return headers_.Find(base, name);}
+
+    /*!
+    @brief 返回实体数据在请求报文中的起始位置，即请求行和首部行的总字节数。
+    */
+    size_t HeaderEnd() const {return header_end_;}
+private:
+    /*!
+    @brief 检查scan_pos_处的行结束符。
+
+    @return 1表示行结束符完整且scan_pos_已移到下一行行首，0表示数据不完整，-1表示格式错误。
+    */
+    int ConsumeLineEnd(const char* data, size_t len);
+};
+
+#endif //WEBSERVER_HTTPPARSER_H
@@ -0,0 +1,48 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/21 上午9:30
+*/
+#ifndef WEBSERVER_HTTPRANGE_H
+#define WEBSERVER_HTTPRANGE_H
+
+/*Linux system APIS*/
+#include <sys/types.h>
+
+/*STD Headers*/
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+/*!
+@brief 实体中的一段区间[first, last]，两端均包含在内。
+*/
+struct ByteRange{
+    off_t first = 0;
+    off_t last = 0;
+
+    off_t Length() const {return last - first + 1;}
+};
+
+/*!
+@brief Range首部字段的解析结果。
+*/
+enum class RangeParseResult{
+    kIgnored,            //语法错误、单位不是bytes或区间过多，按普通请求返回整个实体
+    kSatisfiable,        //至少有一个区间可以满足，返回206
+    kUnsatisfiable,      //所有区间都超出了实体的范围，返回416
+};
+
+constexpr size_t kMaxRangeNum = 16;             //一个请求最多的区间数，超出时忽略Range
+
+/*!
+@brief 解析Range首部字段(RFC 7233)。
+
+支持"first-last"、"first-"以及"-suffix_length"三种形式，多个区间以逗号分隔。超出实体末尾的last
+会被截断，完全超出实体范围的区间会被丢弃。
+@param[in]  value   Range字段的值。
+@param[in]  size    实体的大小。
+@param[out] ranges  可以满足的区间，按请求中的顺序排列。
+*/
+RangeParseResult ParseByteRanges(std::string_view value, off_t size, std::pmr::vector<ByteRange>& ranges);
+
+#endif //WEBSERVER_HTTPRANGE_H
@@ -0,0 +1,115 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/22 上午10:05
+*/
+#ifndef WEBSERVER_HTTPRESPONSE_H
+#define WEBSERVER_HTTPRESPONSE_H
+
+/*Linux system APIS*/
+#include <time.h>
+
+/*STD Headers*/
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/*!
+@brief 服务器会返回的状态码。
+*/
+enum class HttpStatus : uint8_t{
+    kOk,
+    kPartialContent,
+    kNotModified,
+    kBadRequest,
+    kNotFound,
+    kRequestTimeout,
+    kRangeNotSatisfiable,
+    kNotImplemented,
+    kServiceUnavailable,
+};
+
+constexpr size_t kHttpStatusNum = 9;
+
+/*!
+@brief 渲染好的状态行，以HttpStatus为下标。
+
+服务器总是以自己支持的最高版本HTTP/1.1作答(RFC 7230 2.6)，状态行因此与请求无关。
+*/
+constexpr std::array<std::string_view, kHttpStatusNum> kStatusLines{
+    "HTTP/1.1 200 OK\r\n",
+    "HTTP/1.1 206 Partial Content\r\n",
+    "HTTP/1.1 304 Not Modified\r\n",
+    "HTTP/1.1 400 Bad Request\r\n",
+    "HTTP/1.1 404 Not Found\r\n",
+    "HTTP/1.1 408 Request Time-out\r\n",
+    "HTTP/1.1 416 Range Not Satisfiable\r\n",
+    "HTTP/1.1 501 Not Implemented\r\n",
+    "HTTP/1.1 503 Service Unavailable\r\n",
+};
+
+constexpr std::string_view StatusLine(HttpStatus status) {return kStatusLines[static_cast<size_t>(status)];}
+
+/*!
+@brief 每个线程缓存的Date首部行。
+
+由SubReactor的时间轮在每次tick时刷新，生成响应报文时直接拷贝，不再为每个响应调用gmtime和strftime。
+每个线程各有一份，不需要加锁。
+*/
+class HttpDate{
+public:
+    static constexpr size_t kLineSize = 37;         //"Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+private:
+    static thread_local char line_[kLineSize + 1];
+    static thread_local time_t seconds_;            //line_对应的时间，0表示还未生成
+public:
+    /*!
+    @brief 时间变化时重新生成Date首部行。
+    */
+    static void Refresh(time_t now);
+
+    /*!
+    @brief 返回当前线程缓存的Date首部行(含结尾的\r\n)。
+    */
+    static std::string_view Line()
+    {
+        if(seconds_ == 0) Refresh(time(nullptr));
+        return {line_, kLineSize};
+    }
+};
+
+/*!
+@brief 状态行和Date之后的固定首部行：Server、Connection以及长连接的Keep-Alive。
+
+依赖GlobalVar::keep_alive_timeout_，在第一次调用时生成，之后不再改变。
+*/
+std::string_view FixedHeaderLines(bool keep_alive);
+
+/*!
+@brief 预先生成的错误页面，除Date外的内容都是固定的。
+
+发送时依次拷贝status_line、HttpDate::Line()以及rest，rest包含其余首部行和实体。
+*/
+struct ErrorPage{
+    std::string_view status_line;
+    std::string_view rest;
+};
+
+/*!
+@brief 返回status对应的错误页面，支持400、404、408、501和503，其它状态码返回400的页面。
+*/
+const ErrorPage& GetErrorPage(HttpStatus status);
+
+/*!
+@brief 在栈上格式化"name: value\r\n"形式的数字首部行，不分配内存。
+*/
+class NumericHeader{
+private:
+    char buffer_[64];
+    size_t size_ = 0;
+public:
+    NumericHeader(std::string_view name, uint64_t value);
+
+    std::string_view View() const {return {buffer_, size_};}
+};
+
+#endif //WEBSERVER_HTTPRESPONSE_H
@@ -15,6 +15,7 @@
 
 /*User-define Headers*/
 #include "NonCopyable.h"
+#include "LoadBalancer.h"
 
 /*前向声明*/
 class EventLoop;
@@ -32,8 +33,7 @@ private:
     EventLoop* p_main_reactor_;                               //MainReactor
     std::vector<std::shared_ptr<EventLoop>> sub_reactors_;    //SubReactors
     ThreadPool* p_sub_thread_pool_;                           //管理子线程的线程池
-public:
-    std::vector<int> tickfds_{};                              //所有SubReactor的tickfd的写端文件描述符
+    std::unique_ptr<LoadBalancer> balancer_;                  //MainReactor分发新连接的策略，SO_REUSEPORT模式下不使用
 public:
     /*!
     @brief 限制对象数量并禁止复制和赋值
@@ -47,19 +47,48 @@ public:
     void Start();
     
     /*!
-    @brief 关闭服务器
+    @brief 关闭服务器，等待所有SubReactor断开连接后返回。
     */
     void Quit();
+
 private:
     /*!
     @brief 私有构造函数以限制对象的数量
     */
     HttpServer(int port, EventLoop* main_reactor,ThreadPool* sub_thread_pool);
 
+    /*!
+    @brief 设置监听socket的回调函数并加入loop：支持异步I/O时用multishot accept，否则监听EPOLLIN。
+
+    @param[in] reactor   同NewConnHandler。
+    */
+    void AddListenChannel(EventLoop* loop, Channel* listen_channel, EventLoop* reactor);
+
     /*!
     @brief 监听socket的EPOLLIN回调函数
+
+    @param[in] listenfd  就绪的监听socket。
+    @param[in] reactor   SO_REUSEPORT模式下为监听socket所属的SubReactor，连接直接交给它处理；
+                         nullptr表示由MainReactor按balancer_选择SubReactor。
+    */
+    void NewConnHandler(int listenfd, EventLoop* reactor);
+
+    /*!
+    @brief multishot accept的回调函数。
+
+    @param[in] connfd    新的连接socket，出错时为-errno。
+    @param[in] reactor   同NewConnHandler。
+    */
+    void AcceptHandler(int connfd, EventLoop* reactor);
+
+    /*!
+    @brief 检查连接数上限后把连接交给SubReactor。
+
+    @param[in] connfd       非阻塞的连接socket。
+    @param[in] client_addr  客户端地址，只有分发策略用到时才有效。
+    @param[in] reactor      同NewConnHandler。
     */
-    void NewConnHandler();
+    void DispatchConnection(int connfd, const sockaddr_in& client_addr, EventLoop* reactor);
 
     /*!
     @brief 监听socket的EPOLLERR回调函数
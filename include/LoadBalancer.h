@@ -0,0 +1,69 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/23 上午9:40
+*/
+#ifndef WEBSERVER_LOADBALANCER_H
+#define WEBSERVER_LOADBALANCER_H
+
+/*Linux system APIS*/
+#include <netinet/in.h>
+
+/*STD Headers*/
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+
+/*前向声明*/
+class EventLoop;
+
+/*!
+@brief MainReactor分发新连接的策略。
+*/
+enum class BalancePolicy{
+    kLeastConn,          //连接数最少，需要扫描所有SubReactor
+    kRoundRobin,         //轮流分发
+    kPowerOfTwo,         //随机选两个SubReactor，取连接数较少的一个
+    kIpHash,             //按客户端IP哈希，同一客户端总是由同一个SubReactor处理
+    kLeastBusy,          //最近忙碌时间最短
+};
+
+/*!
+@brief 根据名字解析分发策略：least_conn、round_robin、p2c、ip_hash、least_busy。
+*/
+std::optional<BalancePolicy> ParseBalancePolicy(std::string_view name);
+
+/*!
+@brief 连接分发策略的接口。
+
+Select只由MainReactor调用，各个SubReactor的负载(连接数、忙碌时间)都是relaxed原子变量，读取时不加锁。
+*/
+class LoadBalancer : private NonCopyable {
+protected:
+    std::vector<EventLoop*> reactors_;
+public:
+    explicit LoadBalancer(std::vector<EventLoop*> reactors) : reactors_(std::move(reactors)) {}
+    virtual ~LoadBalancer() = default;
+
+    /*!
+    @brief 为新连接选择一个SubReactor。
+
+    @param[in] client 客户端地址。
+    */
+    virtual EventLoop* Select(const sockaddr_in& client) = 0;
+
+    /*!
+    @brief Select是否用到客户端地址。multishot accept不返回地址，用不到时可以省去getpeername。
+    */
+    virtual bool NeedsClientAddress() const {return false;}
+
+    /*!
+    @brief 创建policy对应的分发策略，reactors不能为空。
+    */
+    static std::unique_ptr<LoadBalancer> Create(BalancePolicy policy, std::vector<EventLoop*> reactors);
+};
+
+#endif //WEBSERVER_LOADBALANCER_H
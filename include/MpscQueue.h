@@ -0,0 +1,77 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/22 下午3:20
+*/
+#ifndef WEBSERVER_MPSCQUEUE_H
+#define WEBSERVER_MPSCQUEUE_H
+
+/*STD Headers*/
+#include <atomic>
+#include <utility>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+
+/*!
+@brief 无锁的多生产者单消费者队列(Dmitry Vyukov的算法)。
+
+生产者只需一次原子交换即可入队，互相之间不会阻塞；只有一个线程可以出队。tail_总是指向一个
+已经出队的哑节点，出队时把下一个节点变成新的哑节点，因此生产者和消费者永远不会修改同一个节点。
+生产者在交换head_之后、链接next之前被挂起时，后面入队的节点暂时对消费者不可见，消费者会认为
+队列为空。调用者需要在入队完成后再唤醒消费者，以保证不会漏掉节点。
+*/
+template<typename T>
+class MpscQueue : private NonCopyable {
+private:
+    struct Node{
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node*> head_;        //最后入队的节点，由生产者修改
+    Node* tail_;                     //哑节点，只由消费者访问
+public:
+    MpscQueue()
+    {
+        auto stub = new Node;
+        head_.store(stub, std::memory_order_relaxed);
+        tail_ = stub;
+    }
+
+    ~MpscQueue()
+    {
+        T value;
+        while(Pop(value)) {}
+        delete tail_;
+    }
+
+    /*!
+    @brief 入队，任意线程都可以调用。
+    */
+    void Push(T value)
+    {
+        auto node = new Node;
+        node->value = std::move(value);
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /*!
+    @brief 出队，只能由消费者线程调用。
+
+    @return false表示队列为空。
+    */
+    bool Pop(T& value)
+    {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if(!next) return false;
+        value = std::move(next->value);
+        next->value = T{};           //哑节点不再持有数据，例如std::function捕获的对象
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+};
+
+#endif //WEBSERVER_MPSCQUEUE_H
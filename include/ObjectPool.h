@@ -0,0 +1,104 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/24 下午3:30
+*/
+#ifndef WEBSERVER_OBJECTPOOL_H
+#define WEBSERVER_OBJECTPOOL_H
+
+/*STD Headers*/
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*User-define Headers*/
+#include "Utility.h"
+
+/*!
+@brief 线程局部的对象池，回收的对象连同其中的缓冲区一起复用。
+
+每个线程有自己的空闲链表，取出和放回都不需要加锁。对象在一个线程取出后可以在另一个线程放回，
+此时放入后者的空闲链表。连接在哪个SubReactor中建立就在哪个SubReactor中关闭，因此对象基本在
+同一个线程中循环使用。
+
+T需要提供两个成员函数：
+- Reuse(args...)：复用时代替构造函数，参数与构造函数相同。
+- Recycle()：放回池中之前释放对象持有的外部资源(文件描述符、回调函数等)，但保留自己的缓冲区。
+
+空闲对象超过高水位GlobalVar::object_pool_high_时释放到低水位GlobalVar::object_pool_low_，避免
+连接数回落后一直占用峰值时的内存。容量按每个线程的每种对象分别计算。
+*/
+template<typename T>
+class ObjectPool{
+private:
+    struct FreeList{
+        std::vector<T*> objects;
+        ~FreeList() {for (auto object : objects) delete object;}
+    };
+
+    static FreeList& Local()
+    {
+        thread_local FreeList free_list;
+        return free_list;
+    }
+public:
+    /*!
+    @brief 取出一个对象，空闲链表为空时新建。
+    */
+    template<typename... Args>
+    static T* Acquire(Args&&... args)
+    {
+        auto& objects = Local().objects;
+        if(objects.empty()) return new T(std::forward<Args>(args)...);
+        T* object = objects.back();
+        objects.pop_back();
+        object->Reuse(std::forward<Args>(args)...);
+        return object;
+    }
+
+    /*!
+    @brief 放回对象。
+    */
+    static void Release(T* object)
+    {
+        if(!object) return;
+        object->Recycle();
+        auto& objects = Local().objects;
+        objects.push_back(object);
+        if(objects.size() > GlobalVar::object_pool_high_)
+        {
+            while(objects.size() > GlobalVar::object_pool_low_)
+            {
+                delete objects.back();
+                objects.pop_back();
+            }
+        }
+    }
+
+    /*!
+    @brief 在当前线程预先创建对象，使空闲对象达到GlobalVar::object_pool_warm_个。T需要有默认构造函数。
+    */
+    static void Warm()
+    {
+        auto& objects = Local().objects;
+        objects.reserve(GlobalVar::object_pool_high_ + 1);
+        while(objects.size() < GlobalVar::object_pool_warm_) objects.push_back(new T());
+    }
+
+    /*!
+    @brief 当前线程的空闲对象数。
+    */
+    static size_t FreeSize() {return Local().objects.size();}
+};
+
+/*!
+@brief 析构时把对象放回对象池的unique_ptr。
+*/
+template<typename T>
+struct PoolDeleter{
+    void operator()(T* object) const {ObjectPool<T>::Release(object);}
+};
+
+template<typename T>
+using PoolPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+#endif //WEBSERVER_OBJECTPOOL_H
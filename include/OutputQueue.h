@@ -0,0 +1,136 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/19 下午2:15
+*/
+#ifndef WEBSERVER_OUTPUTQUEUE_H
+#define WEBSERVER_OUTPUTQUEUE_H
+
+/*Linux system APIS*/
+#include <sys/types.h>
+#include <sys/socket.h>
+
+/*STD Headers*/
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*!
+@brief 响应报文的输出队列，由若干段数据组成，内存中的数据用sendmsg一次写出多段，文件用sendfile发送。
+
+段的类型有四种：
+- 自有数据：队列自己持有的std::string，用于首部行等动态生成的内容。连续追加的自有数据会合并成一段。
+- 静态数据：生命周期长于队列的数据，例如字符串字面量，只保存指针。
+- 共享数据：不可变的数据块，通过shared_ptr保持其存活，例如文件的mmap映射区。
+- 文件：文件中的一段区域，由内核直接从page cache发送到socket，数据不经过用户态。
+
+后三种不会拷贝数据。队列只记录首段已经发送的字节数，部分写出时下一次从断点继续，因此无论文件多大，
+每个连接占用的内存都是固定的。
+*/
+class OutputQueue {
+public:
+    static const int kMaxIovecNum = 64;              //一次sendmsg最多写出的段数
+private:
+    enum class SegmentType : uint8_t{
+        kOwned,
+        kStatic,
+        kShared,
+        kFile,
+    };
+
+    struct Segment{
+        SegmentType type;
+        std::string owned{};                         //kOwned时的数据
+        std::shared_ptr<const void> holder{};        //kShared和kFile时保持数据存活
+        const char* data = nullptr;                  //kStatic和kShared时的数据
+        size_t size = 0;
+        int file_fd = -1;                            //kFile时的文件描述符
+        off_t file_offset = 0;                       //kFile时的起始偏移量
+
+        const char* Data() const {return type == SegmentType::kOwned ? owned.data() : data;}
+        size_t Size() const      {return type == SegmentType::kOwned ? owned.size() : size;}
+    };
+
+    std::deque<Segment> segments_;
+    size_t front_offset_ = 0;                        //首段中已经发送的字节数
+    size_t bytes_ = 0;                               //还未发送的总字节数
+    std::string spare_;                              //回收的自有数据缓冲区，下一个自有段直接复用，避免重复分配
+public:
+    OutputQueue() = default;
+    OutputQueue(const OutputQueue&) = delete;
+    OutputQueue& operator=(const OutputQueue&) = delete;
+
+    /*!
+    @brief 还未发送的字节数。
+    */
+    size_t ReadableBytes() const {return bytes_;}
+    bool Empty() const           {return bytes_ == 0;}
+
+    /*!
+    @brief 追加自有数据，会拷贝data。
+    */
+    void Append(std::string_view data);
+    void Append(const char* data) {Append(std::string_view(data));}
+    void Append(std::string&& data);
+
+    /*!
+    @brief 追加n字节的自有数据并返回其起始地址，由调用者在下一次修改队列之前填充。
+
+    需要对数据做变换后再发送时直接写入输出队列，不必先写到临时缓冲区再拷贝一次。
+    */
+    char* AppendUninitialized(size_t n);
+
+    /*!
+    @brief 追加静态数据，调用者需保证数据在发送完之前一直有效。
+    */
+    void AppendStatic(const char* data, size_t n);
+
+    /*!
+    @brief 追加共享数据，holder保证data在发送完之前一直有效。
+    */
+    void AppendShared(std::shared_ptr<const void> holder, const char* data, size_t n);
+
+    /*!
+    @brief 追加文件中从offset开始的n个字节，holder保证file_fd在发送完之前一直打开。
+    */
+    void AppendFile(std::shared_ptr<const void> holder, int file_fd, off_t offset, size_t n);
+
+    /*!
+    @brief 丢弃所有数据。
+    */
+    void Clear();
+
+    /*!
+    @brief 写出队列头部的数据，并删除已经写完的段。
+
+    首段是文件时调用一次sendfile，否则用一次sendmsg写出头部连续的内存段。内存段后面紧跟着文件时
+    带上MSG_MORE，让首部行和文件的开头尽量合并在同一个TCP报文段中。
+    @param[in]  fd          连接socket的文件描述符。
+    @param[out] saved_errno 出错时的errno。
+    @return     sendmsg或sendfile的返回值。
+    */
+    ssize_t WriteFd(int fd, int* saved_errno);
+
+    /*!
+    @brief 用头部连续的内存段填写msg，供异步的sendmsg使用，不修改队列。
+
+    队列在sendmsg完成之前不能修改，完成后用Retrieve删除写出的字节。
+    @param[out] msg  msg_iov指向iov，其余字段清零。
+    @param[out] iov  至少kMaxIovecNum个元素。
+    @return     sendmsg使用的flags；首段是文件或队列为空时返回-1，此时应调用WriteFd。
+    */
+    int FillMsg(msghdr& msg, iovec* iov) const;
+
+    /*!
+    @brief 删除已经写出的n个字节。
+    */
+    void Retrieve(size_t n);
+private:
+
+    /*!
+    @brief 删除首段，自有数据的缓冲区留给下一个自有段使用。
+    */
+    void PopFront();
+};
+
+#endif //WEBSERVER_OUTPUTQUEUE_H
@@ -0,0 +1,145 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/25 上午9:20
+*/
+#ifndef WEBSERVER_POLLER_H
+#define WEBSERVER_POLLER_H
+
+/*Linux system APIS*/
+#include <sys/socket.h>
+
+/*STD Headers*/
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+
+/*!
+@brief 事件循环使用的I/O多路复用后端。
+*/
+enum class PollerBackend{
+    kEpoll,              //epoll_wait/epoll_ctl
+    kIoUring,            //io_uring的multishot accept/recv、sendmsg以及定时，内核不支持时退回epoll
+};
+
+/*!
+@brief 根据名字解析后端：epoll、io_uring。
+*/
+std::optional<PollerBackend> ParsePollerBackend(std::string_view name);
+
+/*!
+@brief 事件的类型。epoll后端只产生kReady，支持异步I/O的后端还会产生其余几种完成事件。
+*/
+enum class EventType : uint8_t{
+    kReady,              //fd就绪，events有效
+    kAccept,             //multishot accept收到新连接，result为连接socket，出错时为-errno
+    kRecv,               //multishot recv读到数据，data和result为数据及其长度，0表示对端关闭，出错时为-errno
+    kSend,               //sendmsg完成，result为写出的字节数，出错时为-errno
+    kTick,               //周期定时器到期，result为到期次数，fd无意义
+};
+
+/*!
+@brief 就绪的文件描述符及其就绪事件，事件使用与epoll相同的EPOLLIN、EPOLLOUT等标志。
+*/
+struct ReadyEvent{
+    int fd;
+    uint32_t events;
+    EventType type = EventType::kReady;
+    int result = 0;
+    const char* data = nullptr;          //kRecv时的数据，下一次Poll之前有效
+    uint32_t generation = 0;             //后端用来判断事件是否已经过期
+};
+
+/*!
+@brief I/O多路复用的接口，所有成员函数都只能在事件循环所在的线程中调用。
+
+注册的事件都是边沿触发的：文件描述符从未就绪变为就绪时才会报告一次，回调函数需要一直读写到EAGAIN。
+
+支持异步I/O的后端(SupportsAsyncIo)还可以直接完成accept、recv和sendmsg：监听socket由AddAcceptor注册，
+连接socket由AddConnection注册，读到的数据和新连接以完成事件的形式返回，发送由Send提交，时间轮由
+StartTicker驱动。这些请求和完成都在Poll的一次系统调用中批量进出内核，读写数据不再需要单独的系统调用。
+*/
+class Poller : private NonCopyable {
+public:
+    Poller() = default;
+    virtual ~Poller() = default;
+
+    /*!
+    @brief 开始监听fd上的events事件。
+    */
+    virtual bool Add(int fd, uint32_t events) = 0;
+
+    /*!
+    @brief 将fd监听的事件修改为events。
+    */
+    virtual bool Mod(int fd, uint32_t events) = 0;
+
+    /*!
+    @brief 停止监听fd，必须在关闭fd之前调用。
+    */
+    virtual bool Del(int fd) = 0;
+
+    /*!
+    @brief 等待事件，最多等待timeout_ms毫秒。
+
+    @param[out] active_events 就绪的事件，调用前会被清空。
+    @return     就绪事件的数量，出错时返回-1并设置errno。
+    */
+    virtual int Poll(int timeout_ms, std::vector<ReadyEvent>& active_events) = 0;
+
+    /*!
+    @brief 后端的名字，用于日志。
+    */
+    virtual const char* Name() const = 0;
+
+    /*!
+    @brief 是否支持下面的异步I/O接口。不支持时这些接口都返回false，调用者使用就绪事件以及非阻塞的
+    accept/recv/sendmsg。
+    */
+    virtual bool SupportsAsyncIo() const {return false;}
+
+    /*!
+    @brief 在监听socket上注册multishot accept，每个新连接产生一个kAccept事件，连接socket是非阻塞的。
+    */
+    virtual bool AddAcceptor(int /*listenfd*/) {return false;}
+
+    /*!
+    @brief 注册连接socket，用multishot recv读取数据，每次读到数据产生一个kRecv事件。
+
+    之后的Mod只用于等待EPOLLOUT(sendfile写满发送缓冲区时)，读事件和错误都由kRecv报告。
+    */
+    virtual bool AddConnection(int /*fd*/) {return false;}
+
+    /*!
+    @brief 暂停或恢复连接socket上的recv，输入积压太多时暂停。暂停之前已经读到的数据仍会产生kRecv事件。
+    */
+    virtual void PauseRecv(int /*fd*/) {}
+    virtual void ResumeRecv(int /*fd*/) {}
+
+    /*!
+    @brief 提交sendmsg，完成时产生kSend事件。msg及其指向的数据在完成之前必须保持有效。
+    */
+    virtual bool Send(int /*fd*/, const msghdr* /*msg*/, int /*flags*/) {return false;}
+
+    /*!
+    @brief 每隔interval产生一个kTick事件，事件循环被阻塞时合并为一个事件并给出到期次数。
+    */
+    virtual bool StartTicker(std::chrono::milliseconds /*interval*/) {return false;}
+
+    /*!
+    @brief 事件是否已经过期：Poll返回之后，同一批事件中前面的回调函数注销(甚至复用)了该fd。
+    */
+    virtual bool IsStale(const ReadyEvent& /*event*/) const {return false;}
+
+    /*!
+    @brief 创建backend对应的后端，io_uring不可用时退回epoll。全部失败时返回nullptr。
+    */
+    static std::unique_ptr<Poller> Create(PollerBackend backend);
+};
+
+#endif //WEBSERVER_POLLER_H
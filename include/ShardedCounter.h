@@ -0,0 +1,69 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/23 下午2:05
+*/
+#ifndef WEBSERVER_SHARDEDCOUNTER_H
+#define WEBSERVER_SHARDEDCOUNTER_H
+
+/*STD Headers*/
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+
+constexpr size_t kCacheLineSize = 64;
+
+/*!
+@brief 独占一个cache line的原子变量，避免与相邻的变量伪共享。
+*/
+template<typename T>
+struct alignas(kCacheLineSize) PaddedAtomic{
+    std::atomic<T> value{};
+
+    T Load() const {return value.load(std::memory_order_relaxed);}
+    void Add(T n)  {value.fetch_add(n, std::memory_order_relaxed);}
+};
+
+/*!
+@brief 分片计数器。
+
+每个线程固定使用其中一个分片，各分片独占cache line，修改时只有relaxed的原子加减，线程之间几乎不会
+竞争同一个cache line。读取时累加所有分片，得到的值在并发修改时只是近似值，但不会有累积误差，
+适合连接数限制、监控统计这类读少写多的计数。
+*/
+class ShardedCounter : private NonCopyable {
+public:
+    static constexpr size_t kShardNum = 16;
+private:
+    std::array<PaddedAtomic<int64_t>, kShardNum> shards_{};
+
+    /*!
+    @brief 当前线程使用的分片，线程第一次调用时按顺序分配。
+    */
+    static size_t ThisShard()
+    {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShardNum;
+        return shard;
+    }
+public:
+    ShardedCounter() = default;
+
+    void Add(int64_t n) {shards_[ThisShard()].Add(n);}
+    void Increment()    {Add(1);}
+    void Decrement()    {Add(-1);}
+
+    /*!
+    @brief 返回所有分片的和。
+    */
+    int64_t Sum() const
+    {
+        int64_t sum = 0;
+        for (const auto& shard : shards_) sum += shard.Load();
+        return sum;
+    }
+};
+
+#endif //WEBSERVER_SHARDEDCOUNTER_H
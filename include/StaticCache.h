@@ -0,0 +1,175 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/20 上午10:20
+*/
+#ifndef WEBSERVER_STATICCACHE_H
+#define WEBSERVER_STATICCACHE_H
+
+/*STD Headers*/
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*User-define Headers*/
+#include "NonCopyable.h"
+#include "FileCache.h"
+
+/*前向声明*/
+class Channel;
+
+/*!
+@brief 缓存的静态文件。
+
+header为已经渲染好的Content-Type、Content-Length、Accept-Ranges以及验证器首部行(含结尾的空行)，只有状态行、
+Date以及Connection等和请求相关的字段需要在每次响应时填写。
+*/
+struct CachedFile{
+    std::string header;
+    std::string body;
+    std::string content_type;
+    FileValidators validators;
+};
+
+/*!
+@brief 访问频率的估计器(Count-Min Sketch)。
+
+每个key对应kDepth行中的各一个4位计数器，估计值取其中的最小值。计数总次数达到采样上限后所有计数器
+减半，使很久以前的访问逐渐被遗忘。
+*/
+class FrequencySketch {
+public:
+    static const size_t kDepth = 4;
+private:
+    std::vector<uint8_t> table_;                 //kDepth行计数器，每个字节存两个4位计数器
+    size_t width_mask_;                          //每行计数器数量减1，数量为2的幂
+    size_t additions_ = 0;                       //减半以来的计数次数
+    size_t sample_size_;                         //计数次数达到该值后所有计数器减半
+public:
+    explicit FrequencySketch(size_t width);
+
+    void Increment(size_t hash);
+    uint8_t Estimate(size_t hash) const;
+private:
+    size_t IndexOf(size_t hash, size_t row) const;
+    uint8_t Counter(size_t index) const;
+    void Reset();
+};
+
+/*!
+@brief 静态文件的内存缓存，以资源目录下的文件名为key，所有SubReactor共用。
+
+- 分为kShardNum个分片，每个分片一把锁，各分片的内存预算为总预算的1/kShardNum。
+- 每个分片内部按LRU淘汰，但新文件需要淘汰旧文件时，只有其访问频率(TinyLFU)高于所有将被淘汰的文件
+  才会被接纳，只访问一次的文件不会把热点文件挤出缓存。
+- 通过inotify监听资源目录，文件被修改、删除或移动时使对应的缓存以及FileCache中的文件失效。
+  inotify的Channel由MainReactor监听。
+
+命中时不需要任何文件系统调用，实体直接以共享数据的形式交给输出队列，不会拷贝。
+*/
+class StaticCache : private NonCopyable {
+public:
+    static const size_t kShardNum = 16;
+private:
+    struct Node{
+        std::string key;
+        std::shared_ptr<const CachedFile> file;
+        size_t charge;                           //占用的内存
+    };
+
+    struct Shard{
+        std::mutex mutex;
+        std::list<Node> lru;                     //表头为最近访问的文件
+        std::unordered_map<std::string_view, std::list<Node>::iterator> index;
+        size_t usage = 0;
+        FrequencySketch sketch;
+
+        explicit Shard(size_t sketch_width) : sketch(sketch_width) {}
+    };
+
+    size_t shard_budget_;                        //每个分片的内存预算，0表示不使用缓存
+    size_t max_file_size_;                       //可以缓存的最大文件
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> generation_{0};        //每次失效时加1
+    Channel* p_watch_channel_ = nullptr;         //inotify的Channel
+public:
+    /*!
+    @brief 全局唯一的缓存对象，首次调用时按GlobalVar::static_cache_budget_初始化。
+    */
+    static StaticCache& Instance();
+
+    bool Enabled() const {return shard_budget_ != 0;}
+
+    /*!
+    @brief 查找缓存的文件，同时记录一次访问。未命中时返回nullptr。
+    */
+    std::shared_ptr<const CachedFile> Get(std::string_view key);
+
+    /*!
+    @brief 预先判断文件能否被接纳，避免读取一个最终不会被缓存的文件。
+
+    与Insert按相同的占用(ChargeOf)判断，通过预判的文件插入时不会淘汰超出预判的文件。
+    @param[in] header_size 渲染好的首部行的大小。
+    @param[in] body_size   文件的大小。
+    */
+    bool WouldAdmit(std::string_view key, size_t header_size, size_t body_size);
+
+    /*!
+    @brief 插入文件。
+
+    @param[in] generation 读取文件之前调用Generation()得到的值。读取期间文件发生了变化则不插入，
+                          避免把旧的内容放入缓存。
+    @return    true表示已插入。
+    */
+    bool Insert(std::string_view key, std::shared_ptr<const CachedFile> file, uint64_t generation);
+
+    /*!
+    @brief 当前的失效代数。
+    */
+    uint64_t Generation() const {return generation_.load(std::memory_order_acquire);}
+
+    /*!
+    @brief 使key对应的缓存失效。
+    */
+    void Invalidate(std::string_view key);
+
+    /*!
+    @brief 清空所有缓存。
+    */
+    void Clear();
+
+    /*!
+    @brief 开始监听资源目录，返回inotify的Channel，其生命周期由所在的Reactor管理。失败时返回nullptr。
+    */
+    Channel* WatchDirectory(const std::string& dir);
+private:
+    explicit StaticCache(size_t budget);
+
+    Shard& ShardOf(size_t hash) {return *shards_[hash % kShardNum];}
+
+    /*!
+    @brief 缓存一个文件占用的内存，计入分片的预算。
+    */
+    static size_t ChargeOf(std::string_view key, size_t header_size, size_t body_size)
+    {
+        return header_size + body_size + key.size();
+    }
+
+    /*!
+    @brief 为大小为charge的文件腾出空间需要淘汰的文件是否都比它访问得少。需持有分片的锁。
+    */
+    bool CanAdmit(Shard& shard, size_t charge, uint8_t frequency) const;
+
+    /*!
+    @brief inotify的EPOLLIN回调函数。
+    */
+    void WatchHandler();
+};
+
+#endif //WEBSERVER_STATICCACHE_H
@@ -5,128 +5,217 @@
 #ifndef WEBSERVER_TIMER_H
 #define WEBSERVER_TIMER_H
 
-/*Linux system APIs*/
-#include <unistd.h>
-#include <signal.h>
-
 /*STD Headers*/
-#include <memory>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <functional>
-#include <array>
-#include <list>
-#include <optional>
 
 /*前向声明*/
-class HttpData;
-class Channel;
 class TimeWheel;
 
 /*!
-@brief 定时器
+@brief 侵入式双向循环链表的节点。
+
+时间轮的每个槽是一个哨兵节点，定时器直接链入槽中，加入和删除都不需要分配内存，也不需要查找。
+节点不在任何链表中时prev和next都指向自己。
+*/
+struct TimerNode{
+    TimerNode* prev = this;
+    TimerNode* next = this;
+
+    TimerNode() = default;
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    bool Linked() const {return next != this;}
+
+    /*!
+    @brief 从所在的链表中摘下，不在链表中时什么也不做。
+    */
+    void Unlink()
+    {
+        prev->next = next;
+        next->prev = prev;
+        prev = next = this;
+    }
+
+    /*!
+    @brief 插入到pos之前，pos为哨兵时即插入到链表末尾。
+    */
+    void InsertBefore(TimerNode* pos)
+    {
+        prev = pos->prev;
+        next = pos;
+        pos->prev->next = this;
+        pos->prev = this;
+    }
+};
+
+/*!
+@brief 定时器，嵌入在使用它的对象(例如HttpData)中，生命周期与该对象相同。
 */
-class Timer {
+class Timer : private TimerNode {
 private:
     using CallBack = std::function<void()>;
-    CallBack expired_sHandler_;                //超时回调函数
-    size_t trigger_cycles_;                    //记录定时器在时间轮转多少圈后生效(不是转一次，而是一圈)
-    size_t slot_index_;                        //记录定时器属于时间轮上的哪个槽
+    CallBack expired_handler_;                 //超时回调函数
+    uint64_t expire_tick_ = 0;                 //到期时时间轮的tick数
+    uint64_t scheduled_tick_ = 0;              //所在槽对应的tick数，不晚于expire_tick_。延后到期时间时不移动定时器
+    TimeWheel* wheel_ = nullptr;               //最近一次加入的时间轮
 public:
     friend class TimeWheel;
-    Timer(size_t cycles, size_t slot_index);
+    Timer() = default;
+    explicit Timer(CallBack expired_handler) : expired_handler_(std::move(expired_handler)) {}
 
     /*!
-    @brief 返回定时器所在槽在时间轮中的编号。
+    @brief 仍在时间轮中时通过TimeWheel::DelTimer删除，保证时间轮的定时器数量正确。
     */
-    size_t GetSlotIndex() const {return slot_index_;};
+    ~Timer();
 
     /*!
-    @brief 返回定时器的触发圈数。
+    @brief 定时器是否在时间轮中等待触发。
     */
-    size_t GetTriggerCycles() const {return trigger_cycles_;}
+    bool IsPending() const {return Linked();}
 
     /*!
-    @brief 定时器的触发圈减1。
+    @brief 返回到期时时间轮的tick数，只在IsPending()时有意义。
     */
-    void ReduceTriggerCyclesByOne() {--trigger_cycles_;}
+    uint64_t GetExpireTick() const {return expire_tick_;}
 
     /*!
     @brief 注册超时回调函数。
     */
-    void SetExpiredHandler(CallBack expired_handler) {expired_sHandler_ = std::move(expired_handler);};
+    void SetExpiredHandler(CallBack expired_handler) {expired_handler_ = std::move(expired_handler);}
 private:
     /*!
     @brief 调用超时回调函数。
     */
-    void CallExpiredHandler();
-
-    /*!
-    @brief 修改定时器的触发圈数。
-    */
-    void SetTriggerCycles(size_t trigger_cycles) { trigger_cycles_ = trigger_cycles;};
-
-    /*!
-    @brief 修改定时器在时间轮中的槽。
-    */
-    void SetSlotIndex(size_t slot_index) {slot_index_ = slot_index;}
+    void CallExpiredHandler() {if(expired_handler_) expired_handler_();}
 };
 
 /*!
-@brief 时间轮
+@brief 分层时间轮。
+
+共kLevelNum层，每层kSlotNum个槽。第0层每个槽对应一个tick，第n层每个槽对应kSlotNum^n个tick，
+第n层覆盖kSlotNum^(n+1)个tick。按默认的tick间隔10毫秒(GlobalVar::slot_interval_)，各层分别覆盖
+640毫秒、41秒、44分钟和46小时。定时器按距离到期的tick数放入能容纳
+它的最低层；低层转完一圈时，上一层当前槽中的定时器重新按剩余时间放入下层(cascade)，最终都在
+第0层的槽中触发。
+
+槽是侵入式链表，加入、删除和重新设置超时时间都是O(1)，与时间轮中的定时器数量无关。每个定时器
+最多被cascade kLevelNum - 1次。
+
+RefreshTimer只延后定时器的到期tick而不移动它，定时器所在的槽先到时才按新的到期tick重新放入时间轮，
+cascade时也直接按到期tick放置。长连接每处理完一个请求都会刷新超时时间，这样连续的请求只需写一个
+整数，一个超时周期内定时器最多被重新放置几次。
+
+大量连接同时建立时它们的定时器也会同时到期。到期的定时器先移到overdue_链表，每次ExpireOverdue最多
+触发expire_budget_个，剩下的留到下一次，事件循环因此不会被一次性关闭成千上万个连接阻塞。加入时间轮
+时还可以给超时时间加上随机抖动，让同时建立的连接分散到不同的槽中。
 */
 class TimeWheel{
+public:
+    static constexpr size_t kLevelBits = 6;
+    static constexpr size_t kSlotNum = size_t(1) << kLevelBits;                    //每层的槽数
+    static constexpr size_t kLevelNum = 4;
+    static constexpr uint64_t kMaxTicks = (uint64_t(1) << (kLevelBits * kLevelNum)) - 1;   //超时时间的上限
 private:
-    std::vector<std::list<Timer*>> slots_;       //时间轮的槽(使用裸指针管理Timer的生命周期)
-    size_t current_slot_ = 0;                    //时间轮的当前槽
-
-    Channel* p_tickfd_channel_;                  //tick_fd_[0]对应的Channel
+    std::array<std::array<TimerNode, kSlotNum>, kLevelNum> slots_;   //各层的槽，每个槽是一个链表的哨兵
+    uint64_t current_tick_ = 0;                  //已经转动的tick数
+    std::chrono::milliseconds tick_interval_;    //tick间隔
+    size_t timer_num_ = 0;                       //时间轮中的定时器数量(包括overdue_中的)
+    TimerNode overdue_;                          //已经到期但还未触发的定时器
+    size_t expire_budget_;                       //每次ExpireOverdue最多触发的定时器数量，0表示不限制
+    uint64_t jitter_ticks_;                      //AddTimer时随机增加的最大tick数
+    uint64_t random_state_ = 0x9e3779b97f4a7c15ULL;   //xorshift64的状态
 public:
-    TimeWheel();
+    /*!
+    @param[in] tick_interval  tick间隔。
+    @param[in] expire_budget  每次ExpireOverdue最多触发的定时器数量，0表示不限制。
+    @param[in] jitter         AddTimer时给超时时间随机增加[0, jitter]，0表示不抖动。
+    */
+    explicit TimeWheel(std::chrono::milliseconds tick_interval, size_t expire_budget = 0,
+                       std::chrono::milliseconds jitter = std::chrono::milliseconds(0));
     ~TimeWheel();
     TimeWheel(const TimeWheel& rhs) = delete;
     TimeWheel& operator=(const TimeWheel& rhs) = delete;
 
     /*!
-    @brief 向时间轮中添加新的定时器。
+    @brief 设置定时器的超时时间，定时器已在时间轮中时重新设置。
 
-    @param[in] timeout 定时器的超时时间。
-    @return    添加的定时器对象的指针。注意，不要delete此指针。
+    以当前时间为基准重新设置一个值为timeout的超时时间而非叠加超时时间。定时器在timeout之后、最多再晚
+    一个tick间隔(以及抖动)触发，超过kMaxTicks个tick的按kMaxTicks计算。
+    @param[in] timer   目标定时器，生命周期由调用者管理。
+    @param[in] timeout 超时时间。
     */
-    Timer* AddTimer(std::chrono::seconds timeout);
+    void AddTimer(Timer* timer, std::chrono::milliseconds timeout);
 
     /*!
-    @brief 从时间轮中删除目标定时器并释放资源。
+    @brief 刷新定时器的超时时间，效果与AddTimer相同。
+
+    定时器已在时间轮中且新的到期时间不早于原来的到期时间(允许相差抖动范围内)时只记录新的到期tick，
+    不移动定时器，否则交给AddTimer。
+    */
+    void RefreshTimer(Timer* timer, std::chrono::milliseconds timeout);
+
+    /*!
+    @brief 从时间轮中删除目标定时器，定时器不在时间轮中时什么也不做。
     */
     void DelTimer(Timer* timer);
 
     /*!
-    @brief 修改目标定时器的超时时间。
+    @brief 时间轮转动一次，把到期的定时器移到overdue_中，不触发。由EventLoop的timerfd回调函数调用。
+    */
+    void Advance();
+
+    /*!
+    @brief 触发overdue_中最多expire_budget_个定时器。
 
-    此函数是以当前时间为基准重新设置一个值为timeout的超时时间而非叠加超时时间。
-    @param[in] timer   目标定时器
-    @param[in] timeout 新的超时时间
+    定时器在调用超时回调函数之前已从时间轮中删除，回调函数中可以重新加入或者销毁定时器。到期时间已被
+    RefreshTimer延后的定时器重新放入时间轮，不计入预算。
+    @return 触发的定时器数量。
     */
-    void AdjustTimer(Timer* timer, std::chrono::seconds timeout);
+    size_t ExpireOverdue();
 
     /*!
-    @brief 返回tick_fd_[0]对应的channel，其生命周期由时间轮对象所在的SubReactor管理。
+    @brief 是否还有到期但未触发的定时器。
     */
-    [[nodiscard]]Channel* GetTickfdChannel() {return p_tickfd_channel_;}
-public:
-    int tick_fd_[2]{};             //用于通知时间轮tick一下的管道
+    bool HasOverdue() const {return overdue_.Linked();}
+
+    /*!
+    @brief Advance之后ExpireOverdue。
+    */
+    void Tick() {Advance(); ExpireOverdue();}
+
+    /*!
+    @brief 返回时间轮中的定时器数量。
+    */
+    size_t Size() const {return timer_num_;}
+
+    /*!
+    @brief 返回已经转动的tick数。
+    */
+    uint64_t GetCurrentTick() const {return current_tick_;}
 private:
     /*!
-    @brief GlobalVar::slot_interval_时间到后，时间轮转动一次
+    @brief 计算超时时间为timeout的定时器的到期tick，不含抖动。
+    */
+    uint64_t ExpireTickOf(std::chrono::milliseconds timeout) const;
+
+    /*!
+    @brief 返回[0, jitter_ticks_]中的随机数。
     */
-    void Tick();
+    uint64_t RandomJitter();
 
     /*!
-    @brief 计算超时时间为timeout的定时器应放置在时间轮的什么位置
+    @brief 按定时器的scheduled_tick_把它放入对应层的槽中。
+    */
+    void Schedule(Timer* timer);
 
-    @param[in] timeout 超时时间
-    @return    pair.first为触发圈数，pair.second为定时器所在槽的索引
+    /*!
+    @brief 把第level层当前槽中的定时器按到期tick重新放入时间轮，该层也转完一圈时先处理上一层。
     */
-    std::optional<std::pair<size_t, size_t>> CalPosInWheel(std::chrono::seconds timeout);
+    void Cascade(size_t level);
 };
 
 #endif //WEBSERVER_TIMER_H
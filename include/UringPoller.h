@@ -0,0 +1,182 @@
+/*！
+@Author: DJJ
+@Date: 2026/10/25 上午10:05
+*/
+#ifndef WEBSERVER_URINGPOLLER_H
+#define WEBSERVER_URINGPOLLER_H
+
+/*Linux system APIS*/
+#include <linux/io_uring.h>
+#include <time.h>
+
+/*User-define Headers*/
+#include "Poller.h"
+#include "FdTable.h"
+
+/*!
+@brief 基于io_uring的Poller，直接使用io_uring_setup/io_uring_enter系统调用，不依赖liburing。
+
+所有请求都只写入提交队列，在下一次Poll时与等待一起通过一次io_uring_enter提交，一轮事件循环无论处理
+多少连接都只有一次系统调用：
+- 监听socket注册multishot accept，内核每接受一个连接投递一项，不再调用accept。
+- 连接socket注册multishot recv，数据由内核写入注册的缓冲区环(provided buffer ring)中的缓冲区，回调
+  函数处理完之后，下一次Poll时缓冲区归还给内核，不再调用recv。
+- 响应报文以sendmsg请求提交，使用MSG_WAITALL，内核在发送缓冲区满时自己等待，完成时才投递一项。
+- 时间轮由IORING_OP_TIMEOUT驱动，使用绝对时间，每次到期后按下一个tick的时间重新提交，不需要timerfd。
+- 其它文件描述符(eventfd、inotify以及等待EPOLLOUT的连接)注册multishot poll(IORING_POLL_ADD_MULTI)。
+
+user_data中带有请求的类型和代数。注销或修改时代数加一，注销之前已经投递的完成项会被丢弃，文件描述符
+被关闭后立刻复用也不会把旧连接的事件交给新连接。
+
+需要5.19及以上的内核(multishot accept、缓冲区环)，multishot recv需要6.0。Init失败时由Poller::Create
+退回epoll；缓冲区环或multishot recv不可用时只使用multishot poll，SupportsAsyncIo返回false。
+*/
+class UringPoller : public Poller {
+private:
+    struct Registration{
+        uint32_t generation = 0;          //Add、AddConnection、AddAcceptor以及Del时加一
+        uint32_t poll_generation = 0;     //poll修改时加一
+        uint32_t events = 0;              //poll监听的事件，0表示没有poll
+        bool active = false;
+        bool connection = false;          //由AddConnection注册，读事件由recv代替
+        bool acceptor = false;            //由AddAcceptor注册
+        bool recv_armed = false;          //multishot recv还在内核中
+        bool recv_paused = false;
+    };
+
+    /*!
+    @brief 请求的类型，保存在user_data的最高8位。
+    */
+    enum class Op : uint8_t{
+        kPoll,
+        kRecv,
+        kSend,
+        kAccept,
+        kTick,
+        kIgnored,                         //POLL_REMOVE、ASYNC_CANCEL的完成项，直接丢弃
+    };
+
+    static constexpr unsigned kEntries = 4096;                    //提交队列的长度，完成队列是它的两倍
+    static constexpr unsigned kBufferNum = 1024;                  //缓冲区环中的缓冲区数量，必须是2的幂
+    static constexpr unsigned kBufferSize = 4096;                 //每个缓冲区的大小
+    static constexpr uint16_t kBufferGroup = 0;
+
+    int ring_fd_ = -1;
+    void* ring_ = nullptr;                                        //提交队列和完成队列共用一次mmap(IORING_FEAT_SINGLE_MMAP)
+    size_t ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;                                       //本地的提交队列尾，写完一项后再发布给内核
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    io_uring_buf_ring* buf_ring_ = nullptr;                       //缓冲区环，内核从中取缓冲区存放recv的数据
+    char* buffers_ = nullptr;                                     //kBufferNum个缓冲区，按需分配物理内存
+    uint16_t buf_tail_ = 0;
+    std::vector<uint16_t> used_buffers_;                          //已经交给回调函数的缓冲区，下一次Poll时归还
+    bool async_io_ = false;
+    std::vector<int> deferred_acceptors_;                         //accept因fd耗尽而终止的监听socket，下一个tick重新注册
+
+    std::chrono::nanoseconds tick_interval_{0};
+    __kernel_timespec tick_deadline_{};                           //下一次tick的绝对时间(CLOCK_MONOTONIC)
+
+    FdTable<Registration> registrations_;
+public:
+    UringPoller() = default;
+    ~UringPoller() override;
+
+    /*!
+    @brief 创建io_uring并映射队列，检查内核是否支持需要的特性。失败时返回false。
+    */
+    bool Init();
+
+    bool Add(int fd, uint32_t events) override;
+    bool Mod(int fd, uint32_t events) override;
+    bool Del(int fd) override;
+    int Poll(int timeout_ms, std::vector<ReadyEvent>& active_events) override;
+    const char* Name() const override {return async_io_ ? "io_uring" : "io_uring(poll only)";}
+
+    bool SupportsAsyncIo() const override {return async_io_;}
+    bool AddAcceptor(int listenfd) override;
+    bool AddConnection(int fd) override;
+    void PauseRecv(int fd) override;
+    void ResumeRecv(int fd) override;
+    bool Send(int fd, const msghdr* msg, int flags) override;
+    bool StartTicker(std::chrono::milliseconds interval) override;
+    bool IsStale(const ReadyEvent& event) const override;
+private:
+    static uint64_t MakeUserData(Op op, int fd, uint32_t generation)
+    {
+        return (uint64_t(op) << 56) | (uint64_t(generation & 0xFFFFFF) << 32) | uint32_t(fd);
+    }
+
+    /*!
+    @brief 向提交队列写入一项，队列已满时先提交已有的项。
+    */
+    bool PushSqe(const io_uring_sqe& sqe);
+
+    /*!
+    @brief 为fd当前的代数注册multishot poll。
+    */
+    bool ArmPoll(int fd, const Registration& registration);
+
+    /*!
+    @brief 取消user_data对应的请求(poll、recv或accept)，完成项被丢弃。
+    */
+    bool Cancel(uint64_t user_data);
+
+    /*!
+    @brief 为连接socket注册multishot recv，或为监听socket注册multishot accept。
+    */
+    bool ArmRecv(int fd, Registration& registration);
+    bool ArmAccept(int fd, const Registration& registration);
+
+    /*!
+    @brief 按tick_deadline_提交下一次tick。
+    */
+    bool ArmTick();
+
+    /*!
+    @brief 注册缓冲区环，并用一个socketpair检查multishot recv是否可用。
+    */
+    bool InitBufferRing();
+
+    /*!
+    @brief 把缓冲区bid放回缓冲区环，ReturnBuffers时才对内核可见。
+    */
+    void RecycleBuffer(uint16_t bid);
+
+    /*!
+    @brief 归还上一次Poll交给回调函数的缓冲区。
+    */
+    void ReturnBuffers();
+
+    /*!
+    @brief 提交队列中还未被内核取走的项数。
+    */
+    unsigned PendingSqes() const;
+
+    /*!
+    @brief 取出完成队列中的所有项，转换为事件。
+    */
+    void ReapCompletions(std::vector<ReadyEvent>& active_events);
+
+    /*!
+    @brief 处理一项完成项。
+    */
+    void HandlePollCompletion(const io_uring_cqe& cqe, int fd, uint32_t generation, std::vector<ReadyEvent>& active_events);
+    void HandleRecvCompletion(const io_uring_cqe& cqe, int fd, uint32_t generation, std::vector<ReadyEvent>& active_events);
+    void HandleAcceptCompletion(const io_uring_cqe& cqe, int fd, uint32_t generation, std::vector<ReadyEvent>& active_events);
+    void HandleTickCompletion(const io_uring_cqe& cqe, std::vector<ReadyEvent>& active_events);
+};
+
+#endif //WEBSERVER_URINGPOLLER_H
@@ -27,49 +27,58 @@
 #include <iostream>
 #include <chrono>
 #include <optional>
+#include <string_view>
+
+/*User-define Headers*/
+#include "LoadBalancer.h"
+#include "Poller.h"
+#include "ShardedCounter.h"
 
 /*Third-Party*/
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/basic_file_sink.h"
 
+/*前向声明*/
+class Buffer;
+class OutputQueue;
+
 /*!
 @brief 全局变量
 */
 struct GlobalVar{
     static const int kMaxUserNum = 100000;               //最大并发连接数量
-    static int total_user_num_;                          //当前总连接数
-    static int slot_num_;                                //时间轮的槽数
-    static std::chrono::seconds slot_interval_;          //时间轮的槽间隔
+    static ShardedCounter total_user_num_;               //当前总连接数，accept和断开连接的线程各自修改自己的分片
+    static std::chrono::milliseconds slot_interval_;     //时间轮的槽间隔(默认10毫秒，-t设置)，每个EventLoop的timerfd按该间隔触发
     static std::chrono::seconds client_header_timeout_;  //tcp连接建立后,必须在该时间内接收到完整的请求行和首部行，否则超时
     static std::chrono::seconds client_body_timeout_;    //实体数据两相邻包到达的间隔时间不能超过该时间，否则超时
     static std::chrono::seconds keep_alive_timeout_;     //长连接的超时时间
+    static size_t timer_expire_budget_;                  //每轮事件循环最多关闭的超时连接数量，剩下的留到下一轮，0表示不限制
+    static std::chrono::milliseconds timeout_jitter_;    //新连接超时时间的随机抖动上限，让同时建立的连接分散超时，0表示不抖动
+    static size_t static_cache_budget_;                  //静态文件缓存的内存预算(字节)，0表示不使用缓存
+    static std::string resource_dir_;                    //静态资源目录
+    static size_t compress_cache_budget_;                //压缩文件缓存的内存预算(字节)
+    static size_t open_file_cache_max_;                  //文件描述符缓存的最大文件数，0表示不使用缓存
+    static std::chrono::seconds open_file_cache_valid_;  //文件描述符缓存中的文件超过该时间后需重新验证
+    static std::chrono::seconds open_file_cache_inactive_;//超过该时间未被使用的文件会被淘汰
+    static bool reuse_port_;                             //每个SubReactor使用自己的SO_REUSEPORT监听socket，不经过MainReactor
+    static BalancePolicy balance_policy_;                //MainReactor分发新连接的策略
+    static PollerBackend poller_backend_;                //事件循环的I/O多路复用后端
+    static size_t object_pool_warm_;                     //每个SubReactor启动时预先创建的Channel和HttpData的数量
+    static size_t object_pool_low_;                      //对象池的低水位
+    static size_t object_pool_high_;                     //对象池的高水位，空闲对象超过该数量时释放到低水位
     static char favicon[555];
     /*!
     @brief 总连接数加一。
     */
-    static void IncTotalUserNum()
-    {
-        std::unique_lock locker(mutex_);
-        ++total_user_num_;
-    }
+    static void IncTotalUserNum() {total_user_num_.Increment();}
     /*!
     @brief 总连接数减一。
     */
-    static void DecTotalUserNum()
-    {
-        std::unique_lock locker(mutex_);
-        --total_user_num_;
-    }
+    static void DecTotalUserNum() {total_user_num_.Decrement();}
     /*!
-    @brief 返回当前总连接数。
+    @brief 返回当前总连接数，并发修改时为近似值，用于kMaxUserNum的限制足够准确。
     */
-    static int GetTotalUserNum()
-    {
-        std::unique_lock locker(mutex_);
-        return total_user_num_;
-    }
-private:
-    static std::mutex mutex_;    //total_user_num_需要互斥访问
+    static int GetTotalUserNum()  {return static_cast<int>(total_user_num_.Sum());}
 };
 
 /*!
@@ -84,13 +93,21 @@ void SetSocketNoDelay(int fd);
 
 /*!
 @brief 绑定端口号并监听。成功时返回监听socket的文件描述符，否则返回-1。全连接队列长度设为2048。
+
+@param[in] port        端口号。
+@param[in] reuse_port  是否设置SO_REUSEPORT，设置后多个socket可以绑定同一端口，由内核分发新连接。
 */
-int BindAndListen(int port);
+int BindAndListen(int port, bool reuse_port = false);
 
 /*!
-@brief 返回GMT时间。
+@brief 将时间t格式化为http报文中使用的GMT时间，例如Sun, 06 Nov 1994 08:49:37 GMT。
 */
-std::string GetTime();
+std::string FormatHttpTime(time_t t);
+
+/*!
+@brief 解析http报文中的GMT时间，格式不正确时返回std::nullopt。
+*/
+std::optional<time_t> ParseHttpTime(std::string_view text);
 
 /*!
 @brief ET模式下从文件描述符(非socket)读n个字节的数据。
@@ -102,15 +119,26 @@ std::string GetTime();
 */
 ssize_t ReadData(int fd, char* dest, size_t n);
 
+/*!
+@brief 从文件的offset处读取n个字节的数据，不改变文件偏移量，可用于多个线程共用的文件描述符。
+
+@param[in] fd      文件描述符。
+@param[in] dest    数据存放的首地址。
+@param[in] n       期望读取的字节数。
+@param[in] offset  文件中的起始位置。
+@return    成功读取的字节数，到达文件末尾时可能小于n。-1表示数据读取出错。
+*/
+ssize_t ReadData(int fd, char* dest, size_t n, off_t offset);
+
 /*!
 @brief ET模式下从连接socket读取数据。
 
 @param[in] fd           连接socket的文件描述符。
-@param[in] buffer       存放数据的string，赋值。
+@param[in] buffer       存放数据的缓冲区，数据追加在其末尾。
 @param[in] disconnect   true表示客户端已断开连接，false表示客户端未断开连接，赋值。
-@return    成功读取的字节数，可能小于n。-1表示数据读取出错。
+@return    成功读取的字节数。-1表示数据读取出错。
 */
-ssize_t ReadData(int fd,std::string& buffer,bool& disconnect);
+ssize_t ReadData(int fd, Buffer& buffer, bool& disconnect);
 
 /*!
 @brief ET模式下向文件描述符(非socket)写n个字节的数据。
@@ -123,14 +151,29 @@ ssize_t ReadData(int fd,std::string& buffer,bool& disconnect);
 ssize_t WriteData(int fd, const char* source, size_t n);
 
 /*!
-@brief ET模式下向连接socket写入数据并删除buffer中成功写出的数据。
+@brief ET模式下向连接socket写入数据并删除queue中成功写出的数据。
 
 @param[in] fd      连接socket的文件描述符。
-@param[in] buffer  待写的数据。
-@param[in] full    true表示写数据失败是由于输出缓冲区已满造成的。
-@return    成功写出的字节数，可能小于n。-1表示写数据出错。
+@param[in] queue   待写的数据。
+@param[in] full    true表示发送缓冲区已满，queue中还有数据未写出。
+@return    成功写出的字节数。-1表示写数据出错。
 */
-ssize_t WriteData(int fd, std::string& buffer, bool& full);
+ssize_t WriteData(int fd, OutputQueue& queue, bool& full);
+
+/*!
+@brief 文件描述符的RAII封装，析构时关闭文件描述符。
+*/
+class FileDescriptor{
+private:
+    int fd_;
+public:
+    explicit FileDescriptor(int fd) : fd_(fd) {}
+    ~FileDescriptor() {if(fd_ >= 0) close(fd_);}
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int Get() const {return fd_;}
+};
 
 /*!
 @brief 用于存放SubReactors的线程池。From: https://github.com/progschj/ThreadPool
@@ -188,6 +231,11 @@ std::shared_ptr<spdlog::logger> GetLogger(std::string path = "../temp/log.txt");
 @return tuple.first  端口号
 @return tuple.second subreactor数量
 @return tuple.third  日志文件路径
+@note   -c 静态文件缓存的大小(MB)，直接写入GlobalVar::static_cache_budget_
+@note   -r 开启SO_REUSEPORT模式，直接写入GlobalVar::reuse_port_
+@note   -b 新连接的分发策略，直接写入GlobalVar::balance_policy_
+@note   -e 事件循环的I/O多路复用后端，直接写入GlobalVar::poller_backend_
+@note   -w 对象池的预热数量，直接写入GlobalVar::object_pool_warm_，水位随之调整
 */
 std::optional<std::tuple<int,size_t ,std::string>> ParaseCommand(int argc,char* argv[]);
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "Buffer.h"
+#include <sys/uio.h>
+#include <errno.h>
+
+void Buffer::Shrink(size_t reserve)
+{
+    std::vector<char> buffer(kCheapPrepend + ReadableBytes() + reserve);
+    memcpy(buffer.data() + kCheapPrepend, Peek(), ReadableBytes());
+    writer_index_ = kCheapPrepend + ReadableBytes();
+    reader_index_ = kCheapPrepend;
+    buffer_.swap(buffer);
+}
+
+ssize_t Buffer::ReadFd(int fd, int* saved_errno)
+{
+    char extra_buffer[kExtraBufferSize];       //不需要初始化，readv只会写入
+    iovec vec[2];
+    const size_t writable = WritableBytes();
+    vec[0].iov_base = BeginWrite();
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extra_buffer;
+    vec[1].iov_len = sizeof extra_buffer;
+    /*可写空间已经足够大时就不需要额外空间了*/
+    const int iovcnt = (writable < sizeof extra_buffer) ? 2 : 1;
+    const ssize_t n = readv(fd, vec, iovcnt);
+    if(n < 0)
+    {
+        *saved_errno = errno;
+    }
+    else if(static_cast<size_t>(n) <= writable)
+    {
+        writer_index_ += n;
+    }
+    else
+    {
+        writer_index_ = buffer_.size();
+        Append(extra_buffer, n - writable);
+    }
+    return n;
+}
+
+void Buffer::MakeSpace(size_t n)
+{
+    if(WritableBytes() + PrependableBytes() < n + kCheapPrepend)
+    {
+        /*vector扩容时容量至少翻倍，所以多次追加的均摊代价是O(1)的*/
+        buffer_.resize(writer_index_ + n);
+    }
+    else
+    {
+        /*把可读数据挪到头部，腾出空间*/
+        size_t readable = ReadableBytes();
+        memmove(buffer_.data() + kCheapPrepend, Peek(), readable);
+        reader_index_ = kCheapPrepend;
+        writer_index_ = reader_index_ + readable;
+    }
+}
@@ -10,7 +10,30 @@ Channel::Channel(int fd, bool is_connfd)
 
 Channel::~Channel()
 {
-    close(fd_);
+    if(fd_ >= 0) close(fd_);
+}
+
+void Channel::Reuse(int fd, bool is_connfd)
+{
+    fd_ = fd;
+    is_connfd_ = is_connfd;
+    events_ = revents_ = last_events_ = 0;
+    p_holder_ = nullptr;
+}
+
+void Channel::Recycle()
+{
+    if(fd_ >= 0) close(fd_);
+    fd_ = -1;
+    /*回调函数捕获了HttpData的this指针，必须清空*/
+    read_handler_ = nullptr;
+    write_handler_ = nullptr;
+    error_handler_ = nullptr;
+    disconn_handler_ = nullptr;
+    accept_handler_ = nullptr;
+    recv_handler_ = nullptr;
+    send_handler_ = nullptr;
+    p_holder_ = nullptr;
 }
 
 void Channel::CallReadHandler()
@@ -52,6 +75,26 @@ void Channel::CallReventsHandlers()
         CallReadHandler();
 }
 
+void Channel::CallCompletionHandler(const ReadyEvent& event)
+{
+    switch (event.type) {
+        case EventType::kAccept:
+            if(accept_handler_) accept_handler_(event.result);
+            else ::GetLogger()->warn("accept handler has not been registered yet");
+            break;
+        case EventType::kRecv:
+            if(recv_handler_) recv_handler_(event.data, event.result);
+            else ::GetLogger()->warn("recv handler has not been registered yet");
+            break;
+        case EventType::kSend:
+            if(send_handler_) send_handler_(event.result);
+            else ::GetLogger()->warn("send handler has not been registered yet");
+            break;
+        default:
+            break;
+    }
+}
+
 bool Channel::EqualAndUpdateLastEvents()
 {
     bool ret = (events_ == last_events_);
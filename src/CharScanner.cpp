@@ -0,0 +1,248 @@
+#include "CharScanner.h"
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WEBSERVER_X86_SIMD 1
+#endif
+
+namespace {
+
+/*!
+@brief RFC 7230中的tchar。
+*/
+constexpr std::array<bool,256> MakeTokenTable()
+{
+    std::array<bool,256> table{};
+    for (int c = '0'; c <= '9'; ++c) table[c] = true;
+    for (int c = 'a'; c <= 'z'; ++c) table[c] = true;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] = true;
+    for (char c : std::string_view("!#$%&'*+-.^_`|~")) table[static_cast<unsigned char>(c)] = true;
+    return table;
+}
+constexpr std::array<bool,256> kTokenTable = MakeTokenTable();
+
+inline bool IsUriChar(unsigned char c)   {return c > 0x20 && c != 0x7f;}
+inline bool IsValueChar(unsigned char c) {return (c >= 0x20 || c == '\t') && c != 0x7f;}
+
+/*-----------------------标量实现-------------------------*/
+size_t ScanTokenScalar(const char* p, size_t n)
+{
+    size_t i = 0;
+    while(i < n && kTokenTable[static_cast<unsigned char>(p[i])]) ++i;
+    return i;
+}
+
+size_t ScanUriScalar(const char* p, size_t n)
+{
+    size_t i = 0;
+    while(i < n && IsUriChar(static_cast<unsigned char>(p[i]))) ++i;
+    return i;
+}
+
+size_t ScanValueScalar(const char* p, size_t n)
+{
+    size_t i = 0;
+    while(i < n && IsValueChar(static_cast<unsigned char>(p[i]))) ++i;
+    return i;
+}
+
+#ifdef WEBSERVER_X86_SIMD
+/*!
+    tchar的判断使用半字节查表：以字符的低4位查表得到一个位图，位图中第k位表示高4位为k的字符
+    是否为tchar；高4位查表得到1 << k(k >= 8时为0，即非ASCII字符均不是tchar)。两者相与为0
+    则说明该字符不是tchar。这样一次pshufb就能完成16/32个字符的分类。
+ */
+struct NibbleTable{
+    alignas(16) uint8_t low[16];
+    alignas(16) uint8_t high[16];
+};
+
+constexpr NibbleTable MakeNibbleTable()
+{
+    NibbleTable table{};
+    for (int c = 0; c < 128; ++c)
+    {
+        if(kTokenTable[c]) table.low[c & 0x0f] |= static_cast<uint8_t>(1u << (c >> 4));
+    }
+    for (int k = 0; k < 8; ++k) table.high[k] = static_cast<uint8_t>(1u << k);
+    return table;
+}
+constexpr NibbleTable kNibbleTable = MakeNibbleTable();
+
+/*-----------------------SSE4.2实现-------------------------*/
+/*!
+    每次检查16个字节的函数必须强制内联：AVX2实现在处理末尾不足32字节的数据时也会调用它们，
+    内联后会被编译成VEX编码的指令，避免SSE与AVX指令混用带来的状态切换开销。
+ */
+#define SSE42_INLINE __attribute__((target("sse4.2"), always_inline)) inline
+
+SSE42_INLINE size_t ScanTokenBlocks16(const char* p, size_t n)
+{
+    const __m128i low_table = _mm_load_si128(reinterpret_cast<const __m128i*>(kNibbleTable.low));
+    const __m128i high_table = _mm_load_si128(reinterpret_cast<const __m128i*>(kNibbleTable.high));
+    const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i low = _mm_shuffle_epi8(low_table, _mm_and_si128(chunk, nibble_mask));
+        __m128i high = _mm_shuffle_epi8(high_table, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble_mask));
+        __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+        int mask = _mm_movemask_epi8(invalid);
+        if(mask) return i + __builtin_ctz(mask);
+    }
+    return i + ScanTokenScalar(p + i, n - i);
+}
+
+/*!
+    URI与首部字段值的非法字符可以表示为几个连续的区间，直接用pcmpestri的区间匹配模式查找。
+ */
+SSE42_INLINE size_t ScanUriBlocks16(const char* p, size_t n)
+{
+    alignas(16) static const char kRanges[16] = "\x00\x20\x7f\x7f";
+    const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(kRanges));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int index = _mm_cmpestri(ranges, 4, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if(index != 16) return i + index;
+    }
+    return i + ScanUriScalar(p + i, n - i);
+}
+
+SSE42_INLINE size_t ScanValueBlocks16(const char* p, size_t n)
+{
+    alignas(16) static const char kRanges[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+    const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(kRanges));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int index = _mm_cmpestri(ranges, 6, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if(index != 16) return i + index;
+    }
+    return i + ScanValueScalar(p + i, n - i);
+}
+
+__attribute__((target("sse4.2"))) size_t ScanTokenSse42(const char* p, size_t n) {return ScanTokenBlocks16(p, n);}
+__attribute__((target("sse4.2"))) size_t ScanUriSse42(const char* p, size_t n)   {return ScanUriBlocks16(p, n);}
+__attribute__((target("sse4.2"))) size_t ScanValueSse42(const char* p, size_t n) {return ScanValueBlocks16(p, n);}
+
+/*-----------------------AVX2实现-------------------------*/
+__attribute__((target("avx2")))
+size_t ScanTokenAvx2(const char* p, size_t n)
+{
+    const __m256i low_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kNibbleTable.low)));
+    const __m256i high_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kNibbleTable.high)));
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(chunk, nibble_mask));
+        __m256i high = _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble_mask));
+        __m256i invalid = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(invalid));
+        if(mask) return i + __builtin_ctz(mask);
+    }
+    return i + ScanTokenBlocks16(p + i, n - i);
+}
+
+/*!
+    AVX2没有无符号比较指令，c <= bound通过max(c, bound) == bound来判断。
+ */
+__attribute__((target("avx2")))
+size_t ScanUriAvx2(const char* p, size_t n)
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i ctl_or_space = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, space), space);
+        __m256i invalid = _mm256_or_si256(ctl_or_space, _mm256_cmpeq_epi8(chunk, del));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(invalid));
+        if(mask) return i + __builtin_ctz(mask);
+    }
+    return i + ScanUriBlocks16(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+size_t ScanValueAvx2(const char* p, size_t n)
+{
+    const __m256i unit_separator = _mm256_set1_epi8(0x1f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i ctl = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, unit_separator), unit_separator);
+        ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), ctl);
+        __m256i invalid = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(chunk, del));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(invalid));
+        if(mask) return i + __builtin_ctz(mask);
+    }
+    return i + ScanValueBlocks16(p + i, n - i);
+}
+#endif
+
+/*!
+@brief 一组扫描函数的实现。
+*/
+struct ScannerImpl{
+    const char* name;
+    size_t (*scan_token)(const char*, size_t);
+    size_t (*scan_uri)(const char*, size_t);
+    size_t (*scan_value)(const char*, size_t);
+};
+
+const ScannerImpl kScalarImpl{"scalar", ScanTokenScalar, ScanUriScalar, ScanValueScalar};
+#ifdef WEBSERVER_X86_SIMD
+const ScannerImpl kSse42Impl{"sse4.2", ScanTokenSse42, ScanUriSse42, ScanValueSse42};
+const ScannerImpl kAvx2Impl{"avx2", ScanTokenAvx2, ScanUriAvx2, ScanValueAvx2};
+#endif
+
+const ScannerImpl* FindImpl(std::string_view name)
+{
+#ifdef WEBSERVER_X86_SIMD
+    __builtin_cpu_init();
+    if(name == "avx2" && __builtin_cpu_supports("avx2")) return &kAvx2Impl;
+    if(name == "sse4.2" && __builtin_cpu_supports("sse4.2")) return &kSse42Impl;
+#endif
+    if(name == "scalar") return &kScalarImpl;
+    return nullptr;
+}
+
+/*!
+@brief 按AVX2 > SSE4.2 > 标量的优先级选择实现，只在程序启动时执行一次。
+*/
+const ScannerImpl* SelectBestImpl()
+{
+    for (auto name : {"avx2", "sse4.2", "scalar"})
+    {
+        if(auto impl = FindImpl(name)) return impl;
+    }
+    return &kScalarImpl;
+}
+
+const ScannerImpl* g_impl = SelectBestImpl();
+
+}
+
+size_t ScanTokenChars(const char* p, size_t n)      {return g_impl->scan_token(p, n);}
+size_t ScanUriChars(const char* p, size_t n)        {return g_impl->scan_uri(p, n);}
+size_t ScanFieldValueChars(const char* p, size_t n) {return g_impl->scan_value(p, n);}
+const char* CharScannerName()                       {return g_impl->name;}
+
+bool SelectCharScanner(std::string_view name)
+{
+    auto impl = FindImpl(name);
+    if(!impl) return false;
+    g_impl = impl;
+    return true;
+}
@@ -0,0 +1,230 @@
+#include "CompressionCache.h"
+#include "HttpHeaders.h"
+#include <zlib.h>
+
+namespace {
+
+std::string_view TrimOws(std::string_view s)
+{
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+/*!
+@brief 判断编码的参数中是否有q=0。
+*/
+bool IsZeroQuality(std::string_view params)
+{
+    while(!params.empty())
+    {
+        auto pos = params.find(';');
+        auto param = TrimOws(params.substr(0, pos));
+        params = (pos == std::string_view::npos ? std::string_view{} : params.substr(pos + 1));
+        if(param.size() < 2 || !EqualsIgnoreCase(param.substr(0, 2), "q=")) continue;
+        auto value = param.substr(2);
+        return !value.empty() && value.find_first_not_of("0.") == std::string_view::npos;
+    }
+    return false;
+}
+
+/*!
+@brief 编码后的文件使用不同的ETag，避免与未编码的文件混淆。
+*/
+FileValidators MakeVariantValidators(const FileValidators& source, std::string_view suffix)
+{
+    FileValidators validators;
+    validators.etag = source.etag.substr(0, source.etag.size() - 1);      //去掉结尾的双引号
+    validators.etag += suffix;
+    validators.etag += '"';
+    validators.last_modified = source.last_modified;
+    validators.header = "ETag: " + validators.etag + "\r\n";
+    validators.header += "Last-Modified: " + FormatHttpTime(validators.last_modified) + "\r\n";
+    return validators;
+}
+
+std::string RenderVariantHeader(const std::string& content_type, std::string_view coding, size_t size,
+                                const FileValidators& validators)
+{
+    std::string header = "Content-Type: " + content_type + "\r\n";
+    header += "Content-Encoding: ";
+    header += coding;
+    header += "\r\nVary: Accept-Encoding\r\n";
+    header += "Content-Length: " + std::to_string(size) + "\r\n";
+    header += "Accept-Ranges: bytes\r\n";
+    header += validators.header;
+    header += "\r\n";
+    return header;
+}
+
+}
+
+unsigned ParseAcceptEncoding(std::string_view value)
+{
+    unsigned accepted = 0;
+    unsigned rejected = 0;
+    bool any = false;
+    while(!value.empty())
+    {
+        auto pos = value.find(',');
+        auto item = TrimOws(value.substr(0, pos));
+        value = (pos == std::string_view::npos ? std::string_view{} : value.substr(pos + 1));
+
+        auto semicolon = item.find(';');
+        auto coding = TrimOws(item.substr(0, semicolon));
+        bool zero = semicolon != std::string_view::npos && IsZeroQuality(item.substr(semicolon + 1));
+        unsigned bit = 0;
+        if(EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "x-gzip")) bit = static_cast<unsigned>(ContentCoding::kGzip);
+        else if(EqualsIgnoreCase(coding, "br")) bit = static_cast<unsigned>(ContentCoding::kBrotli);
+        else if(coding == "*")
+        {
+            any = !zero;
+            continue;
+        }
+        if(zero) rejected |= bit;
+        else accepted |= bit;
+    }
+    /*"*"表示没有明确列出的编码都可以接受*/
+    if(any) accepted |= static_cast<unsigned>(ContentCoding::kGzip) | static_cast<unsigned>(ContentCoding::kBrotli);
+    return accepted & ~rejected;
+}
+
+bool IsCompressibleType(std::string_view content_type)
+{
+    if(content_type.substr(0, 5) == "text/") return true;
+    for (std::string_view keyword : {"javascript", "json", "xml", "svg"})
+    {
+        if(content_type.find(keyword) != std::string_view::npos) return true;
+    }
+    return false;
+}
+
+/*-----------------------CompressionCache类-------------------------*/
+CompressionCache& CompressionCache::Instance()
+{
+    static CompressionCache cache(GlobalVar::compress_cache_budget_);
+    return cache;
+}
+
+const std::string& CompressionCache::MakeKey(std::string_view prefix, std::string_view name)
+{
+    thread_local std::string key;
+    key.assign(prefix);
+    key += name;
+    return key;
+}
+
+std::optional<std::shared_ptr<const CachedFile>> CompressionCache::GetGzip(std::string_view name, const std::string& source_etag)
+{
+    const auto& key = MakeKey("gzip/", name);    //文件名中不会有'/'，加前缀不会冲突
+    std::unique_lock locker(mutex_);
+    auto it = index_.find(key);
+    if(it == index_.end()) return std::nullopt;
+    if(it->second->source_etag != source_etag)
+    {
+        usage_ -= it->second->charge;
+        lru_.erase(it->second);
+        index_.erase(it);
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->file;
+}
+
+void CompressionCache::CompressGzip(std::string_view name, CompressSource source)
+{
+    auto size = static_cast<size_t>(source.size);
+    if(size < kMinCompressSize || size > kMaxCompressSize) return;
+
+    std::string key = MakeKey("gzip/", name);    //后台线程需要自己的副本
+    /*即使是小文件，deflate也会阻塞同一个Reactor上的所有连接，全部交给后台线程，同一个文件只压缩一次*/
+    {
+        std::unique_lock locker(mutex_);
+        if(!pending_.insert(key).second) return;
+    }
+    worker_.AddTaskToPool([this, key, source = std::move(source)](){
+        auto file = Compress(source);
+        std::unique_lock locker(mutex_);
+        pending_.erase(key);
+        Insert(key, source.validators.etag, file);
+    });
+}
+
+std::shared_ptr<const CachedFile> CompressionCache::GetPrecompressed(std::string_view name, ContentCoding coding,
+                                                                     const OpenFile& compressed, const std::string& content_type)
+{
+    bool is_gzip = coding == ContentCoding::kGzip;
+    const auto& key = MakeKey(is_gzip ? "static-gz/" : "static-br/", name);
+    std::unique_lock locker(mutex_);
+    auto it = index_.find(key);
+    if(it != index_.end() && it->second->source_etag == compressed.validators.etag && it->second->file)
+    {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->file;
+    }
+
+    auto file = std::make_shared<CachedFile>();
+    file->content_type = content_type;
+    file->validators = compressed.validators;
+    file->header = RenderVariantHeader(content_type, is_gzip ? "gzip" : "br", compressed.size, file->validators);
+    Insert(key, compressed.validators.etag, file);
+    return file;
+}
+
+std::shared_ptr<const CachedFile> CompressionCache::Compress(const CompressSource& source)
+{
+    auto size = static_cast<size_t>(source.size);
+    std::string input;
+    const char* data = source.data;
+    if(!data)
+    {
+        input.resize(size);
+        if(ReadData(source.fd, input.data(), size, 0) != source.size) return nullptr;
+        data = input.data();
+    }
+
+    z_stream stream{};
+    if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)   //15+16表示gzip格式
+    {
+        ::GetLogger()->error("deflateInit2 error");
+        return nullptr;
+    }
+    auto file = std::make_shared<CachedFile>();
+    file->body.resize(deflateBound(&stream, size));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = reinterpret_cast<Bytef*>(file->body.data());
+    stream.avail_out = static_cast<uInt>(file->body.size());
+    int ret = deflate(&stream, Z_FINISH);
+    file->body.resize(stream.total_out);
+    deflateEnd(&stream);
+    /*压缩后没有小10%以上就不值得压缩了*/
+    if(ret != Z_STREAM_END || file->body.size() >= size - size / 10) return nullptr;
+
+    file->content_type = source.content_type;
+    file->validators = MakeVariantValidators(source.validators, "-gzip");
+    file->header = RenderVariantHeader(file->content_type, "gzip", file->body.size(), file->validators);
+    return file;
+}
+
+void CompressionCache::Insert(const std::string& key, const std::string& source_etag, std::shared_ptr<const CachedFile> file)
+{
+    auto it = index_.find(key);
+    if(it != index_.end())
+    {
+        usage_ -= it->second->charge;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    size_t charge = key.size() + (file ? file->header.size() + file->body.size() : 0);
+    if(charge > budget_) return;
+    while(usage_ + charge > budget_)
+    {
+        usage_ -= lru_.back().charge;
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+    lru_.push_front({key, source_etag, std::move(file), charge});
+    index_.emplace(lru_.front().key, lru_.begin());
+    usage_ += charge;
+}
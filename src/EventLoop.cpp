@@ -2,79 +2,101 @@
 #include "EventLoop.h"
 #include "Channel.h"
 #include "HttpData.h"
+#include "HttpResponse.h"
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 EventLoop::EventLoop(bool is_main_reactor /*false*/)
-                    : epollfd_(epoll_create1(EPOLL_CLOEXEC)),
-                      is_main_reactor_(is_main_reactor)
+                    : poller_(Poller::Create(GlobalVar::poller_backend_)),
+                      async_io_(poller_ && poller_->SupportsAsyncIo()),
+                      is_main_reactor_(is_main_reactor),
+                      wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+                      timewheel_(GlobalVar::slot_interval_, GlobalVar::timer_expire_budget_, GlobalVar::timeout_jitter_)
 {
     /*!
-        注意，这里没有使用epoll_create。这是因为，epoll_create函数的size参数只是一个参考
-        实际上，内核epoll事件表是会动态增长的，因此没有必要使用epoll_create了。并且只有Sub
-        Reactor才需要监听管道的读端
+        其它线程通过写wakeup_fd_唤醒Poll来执行交给本线程的任务。
+        时间轮由本线程自己驱动，不依赖信号处理线程，精度为毫秒：支持异步I/O的Poller用自己的定时请求，
+        否则使用timerfd。
      */
-    if(!AddEpollEvent(timewheel_.GetTickfdChannel()) || epollfd_ == -1)
+    if(!async_io_) tick_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(!poller_ || wakeup_fd_ == -1 || (!async_io_ && tick_fd_ == -1))
     {
-        ::GetLogger()->critical("epoll_create1 error: {}", strerror(errno));
+        ::GetLogger()->critical("create poller, eventfd or timerfd error: {}", strerror(errno));
         exit(-1);
     }
+    active_events_.reserve(kMaxActiveEventNum);
+    auto wakeup_channel = new Channel(wakeup_fd_, false);
+    wakeup_channel->SetEvents(EPOLLIN);
+    wakeup_channel->SetReadHandler([this](){WakeupHandler();});
+    if(!AddEpollEvent(wakeup_channel)) exit(-1);
+    if(async_io_) return;
+    auto tick_channel = new Channel(tick_fd_, false);
+    tick_channel->SetEvents(EPOLLIN);
+    tick_channel->SetReadHandler([this](){TickHandler();});
+    if(!AddEpollEvent(tick_channel)) exit(-1);
 }
 
 EventLoop::~EventLoop()
 {
-    close(epollfd_);
+    /*poller_由unique_ptr释放*/
 }
 
-bool EventLoop::AddEpollEvent(Channel* event_channel, std::chrono::seconds timeout)
+bool EventLoop::AddEpollEvent(Channel* event_channel, std::chrono::milliseconds timeout)
 {
     /*每一个连接socket都必须设置一个表示HttpData对象的holder*/
     if(!event_channel || (event_channel->IsConnfd() && event_channel->GetHolder()== nullptr)) return false;
 
-    /*向epoll内核事件表添加事件*/
+    /*向Poller注册事件*/
     int fd = event_channel->GetFd();
-    epoll_event event;
-    bzero(&event,sizeof event);
-    event.data.fd = fd;
-    event.events = (event_channel->GetEvents() | EPOLLET);
-    if(epoll_ctl(epollfd_,EPOLL_CTL_ADD,fd,&event) < 0)
-    {
-        ::GetLogger()->error("epoll add error: {}", strerror(errno));
-        return false;
-    }
+    /*支持异步I/O时连接socket的数据由recv直接读出，不再监听EPOLLIN*/
+    bool added = (async_io_ && event_channel->IsConnfd()) ? poller_->AddConnection(fd)
+                                                          : poller_->Add(fd, event_channel->GetEvents());
+    if(!added) return false;
     
     /*添加事件成功后才能将事件添加到事件池中。只有连接socket才需设置holder和timer*/
-    events_channel_pool_[event.data.fd] = std::unique_ptr<Channel>(event_channel);
+    events_channel_pool_[fd] = PoolPtr<Channel>(event_channel);
     if(event_channel->GetHolder())
     {
         /*有holder的连接socket才需要将holder保存在事件池中并设置timer。监听socket以及tickfd均不用设置*/
-        http_data_pool_[event.data.fd] = std::unique_ptr<HttpData>(event_channel->GetHolder());
-        auto p_timer = timewheel_.AddTimer(timeout);              //设置timer
-        event_channel->GetHolder()->LinkTimer(p_timer);
-        /*连接数加1*/
-        {
-            std::unique_lock<std::mutex> locker(mutex_for_conn_num_);
-            ++connection_num_;
-        }
+        http_data_pool_[fd] = PoolPtr<HttpData>(event_channel->GetHolder());
+        timewheel_.AddTimer(event_channel->GetHolder()->GetTimer(), timeout);    //设置timer
     }
 
     return true;
 }
 
+bool EventLoop::AddAcceptor(Channel* listen_channel)
+{
+    if(!async_io_ || !listen_channel) return false;
+    int fd = listen_channel->GetFd();
+    if(!poller_->AddAcceptor(fd)) return false;
+    events_channel_pool_[fd] = PoolPtr<Channel>(listen_channel);
+    return true;
+}
+
+bool EventLoop::SendAsync(Channel* event_channel, const msghdr* msg, int flags)
+{
+    return async_io_ && poller_->Send(event_channel->GetFd(), msg, flags);
+}
+
+void EventLoop::PauseRecv(Channel* event_channel)
+{
+    if(async_io_) poller_->PauseRecv(event_channel->GetFd());
+}
+
+void EventLoop::ResumeRecv(Channel* event_channel)
+{
+    if(async_io_) poller_->ResumeRecv(event_channel->GetFd());
+}
+
 bool EventLoop::ModEpollEvent(Channel* event_channel)
 {
     if(!event_channel) return false;
 
     /*修改注册的事件*/
-    int fd = event_channel->GetFd();
     if(!event_channel->EqualAndUpdateLastEvents())
     {
-        epoll_event event{};
-        event.data.fd = fd;
-        event.events = (event_channel->GetEvents() | EPOLLET);
-        if(epoll_ctl(epollfd_,EPOLL_CTL_MOD,fd,&event) < 0)
-        {
-            ::GetLogger()->error("epoll mod error: {}", strerror(errno));
-            return false;
-        }
+        return poller_->Mod(event_channel->GetFd(), event_channel->GetEvents());
     }
 
     return true;
@@ -84,27 +106,16 @@ bool EventLoop::DelEpollEvent(Channel* event_channel)
 {
     if(!event_channel) return false;
 
-    /*从epoll内核事件表中删除事件*/
+    /*从Poller中删除事件*/
     int fd = event_channel->GetFd();
-    epoll_event event;
-    event.data.fd = fd;
-    event.events = 0;
-    if(epoll_ctl(epollfd_,EPOLL_CTL_DEL,fd,&event)<0)
-    {
-        ::GetLogger()->error("epoll del error: {}", strerror(errno));
-        return false;
-    }
+    if(!poller_->Del(fd)) return false;
 
     /*仅连接socket需要删除定时器以及holder*/
     if(event_channel->GetHolder())
     {
         timewheel_.DelTimer(event_channel->GetHolder()->GetTimer());
         http_data_pool_[fd].reset(nullptr);
-        /*连接数减一*/
-        {
-            std::unique_lock<std::mutex> locker(mutex_for_conn_num_);
-            --connection_num_;
-        }
+        connection_num_.Add(-1);             //连接数减一
     }
     events_channel_pool_[fd].reset(nullptr);
 
@@ -113,6 +124,32 @@ bool EventLoop::DelEpollEvent(Channel* event_channel)
 
 void EventLoop::StartLoop()
 {
+    thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+    /*在SubReactor自己的线程中预先创建连接用到的对象*/
+    if(!is_main_reactor_)
+    {
+        ObjectPool<Channel>::Warm();
+        ObjectPool<HttpData>::Warm();
+    }
+    /*事件循环开始时才启动定时器，避免启动前积累的到期次数集中触发*/
+    if(async_io_)
+    {
+        if(!poller_->StartTicker(GlobalVar::slot_interval_)) ::GetLogger()->error("{} start ticker error", poller_->Name());
+    }
+    else
+    {
+        auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(GlobalVar::slot_interval_).count();
+        itimerspec spec{};
+        spec.it_interval.tv_sec = interval / 1000000000;
+        spec.it_interval.tv_nsec = interval % 1000000000;
+        spec.it_value = spec.it_interval;
+        if(timerfd_settime(tick_fd_, 0, &spec, nullptr) < 0)
+        {
+            ::GetLogger()->error("timerfd_settime error: {}", strerror(errno));
+        }
+    }
+    /*执行事件循环开始之前交给本线程的任务*/
+    DoPendingFunctors();
     /*监听*/
     while(!stop_)
     {
@@ -125,49 +162,152 @@ void EventLoop::StartLoop()
 void EventLoop::QuitLoop()
 {
     stop_ = true;
-    for (auto& i : events_channel_pool_)
+    events_channel_pool_.ForEach([this](PoolPtr<Channel>& i){
+        if(i && i->GetFd() != wakeup_fd_) DelEpollEvent(i.get());    //断开所有连接，保留eventfd以免其它线程写入已关闭的fd
+    });
+}
+
+void EventLoop::RunInLoop(Functor func)
+{
+    if(IsInLoopThread()) func();
+    else QueueInLoop(std::move(func));
+}
+
+void EventLoop::QueueInLoop(Functor func)
+{
+    pending_functors_.Push(std::move(func));
+    Wakeup();           //必须在入队之后唤醒
+}
+
+void EventLoop::Wakeup()
+{
+    /*多个任务只需唤醒一次，DoPendingFunctors开始执行前会清除标志*/
+    if(!wakeup_pending_.exchange(true, std::memory_order_acq_rel))
+    {
+        uint64_t one = 1;
+        if(write(wakeup_fd_, &one, sizeof one) != sizeof one)
+        {
+            ::GetLogger()->error("wakeup write error: {}", strerror(errno));
+        }
+    }
+}
+
+void EventLoop::UpdateBusyTime()
+{
+    /*新周期占1/4的权重，既能反映最近的负载，又不会因为一个周期的抖动而大幅变化*/
+    uint64_t recent = recent_busy_ns_.Load();
+    recent_busy_ns_.value.store((recent * 3 + busy_ns_) / 4, std::memory_order_relaxed);
+    busy_ns_ = 0;
+}
+
+void EventLoop::WakeupHandler()
+{
+    uint64_t count = 0;
+    if(read(wakeup_fd_, &count, sizeof count) != sizeof count && errno != EAGAIN)
+    {
+        ::GetLogger()->error("wakeup read error: {}", strerror(errno));
+    }
+}
+
+void EventLoop::TickHandler()
+{
+    uint64_t expirations = 0;
+    if(read(tick_fd_, &expirations, sizeof expirations) != sizeof expirations)
     {
-        if(i) DelEpollEvent(i.get());    //断开所有连接
+        if(errno != EAGAIN) ::GetLogger()->error("timerfd read error: {}", strerror(errno));
+        return;
     }
+    AdvanceTimeWheel(expirations);
 }
 
-int EventLoop::GetConnectionNum()
+void EventLoop::AdvanceTimeWheel(uint64_t expirations)
 {
-    std::unique_lock<std::mutex> locker(mutex_for_conn_num_);
-    return connection_num_;
+    /*顺便刷新本线程缓存的Date首部行*/
+    HttpDate::Refresh(time(nullptr));
+    /*事件循环被阻塞超过一个槽间隔时，一次补上错过的tick。这里只把到期的定时器取出，在本轮循环的最后按预算触发*/
+    for (uint64_t i = 0; i < expirations; ++i) timewheel_.Advance();
+    /*tick间隔只有几毫秒，忙碌时间按固定的周期统计，否则指数加权平均只覆盖几十毫秒*/
+    busy_window_elapsed_ += GlobalVar::slot_interval_ * static_cast<int64_t>(expirations);
+    if(busy_window_elapsed_ >= kBusyTimeWindow)
+    {
+        UpdateBusyTime();
+        busy_window_elapsed_ = std::chrono::milliseconds(0);
+    }
+}
+
+void EventLoop::DoPendingFunctors()
+{
+    /*!
+        先清除标志再取任务。必须用读-改-写而不是store：store之后的Pop中的load可以被提前到store之前
+        (x86也会这样重排)，于是可能既取不到刚入队的任务，入队的线程又看到旧的true而不写eventfd。
+        exchange与Wakeup中的exchange修改同一个原子变量，两者总有先后：Wakeup在后时看到false并写
+        eventfd；在前时这里读到它写的true，与其同步，之后的Pop一定能看到已入队的任务。
+     */
+    wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+    Functor func;
+    int num = 0;
+    while(num < kMaxPendingFunctorNum && pending_functors_.Pop(func))
+    {
+        func();
+        ++num;
+    }
+    /*任务太多时留给下一轮循环，避免饿死socket上的事件*/
+    if(num == kMaxPendingFunctorNum) Wakeup();
 }
 
 void EventLoop::GetActiveEventsAndProc()
 {
     while(!stop_)
     {
-        int active_event_num = epoll_wait(epollfd_,active_events_,kMaxActiveEventNum,kEpollTimeOut);
+        /*还有未触发的超时定时器时不阻塞，处理完就绪事件后继续触发下一批*/
+        int active_event_num = poller_->Poll(timewheel_.HasOverdue() ? 0 : kPollTimeOut, active_events_);
         if(active_event_num < 0 && errno != EINTR)
         {
             /*这里不对系统中断信号作出处理，程序照常运行*/
-            ::GetLogger()->error("eopll wait error: {}", strerror(errno));
+            ::GetLogger()->error("{} wait error: {}", poller_->Name(), strerror(errno));
             return;
         }
-        else if(active_event_num == 0)
+        else if(active_event_num == 0 && !timewheel_.HasOverdue())
         {
-            /*epoll_wait超时，这里的处理方式是继续循环*/
+            /*Poll超时，这里的处理方式是继续循环*/
             continue;
         }
+        auto start = std::chrono::steady_clock::now();
         /*根据就绪事件，找到事件池中相应的Channel修改其revents_属性后再调用相应的回调函数*/
         for (int i = 0; i < active_event_num; ++i)
         {
-            int fd = active_events_[i].data.fd;
-            auto& channel = events_channel_pool_[fd];
+            const ReadyEvent& event = active_events_[i];
+            if(event.type == EventType::kTick)
+            {
+                AdvanceTimeWheel(event.result);
+                continue;
+            }
+            /*同一批事件中前面的回调函数已经关闭(甚至复用)了该fd*/
+            if(poller_->IsStale(event))
+            {
+                if(event.type == EventType::kAccept && event.result >= 0) close(event.result);
+                continue;
+            }
+            auto channel = events_channel_pool_.Find(event.fd);
 
-            if(channel)
+            if(channel && *channel)
             {
-                channel->SetRevents(active_events_[i].events);
-                channel->CallReventsHandlers();
+                if(event.type == EventType::kReady)
+                {
+                    (*channel)->SetRevents(event.events);
+                    (*channel)->CallReventsHandlers();
+                }
+                else (*channel)->CallCompletionHandler(event);
             }
             else
             {
                 ::GetLogger()->warn("Set revents on emtpy Channel Object");
             }
         }
+        /*执行其它线程交给本线程的任务*/
+        DoPendingFunctors();
+        /*关闭一批超时连接，大量连接同时超时时分摊到多轮循环中，不阻塞其它连接上的请求*/
+        if(timewheel_.HasOverdue()) timewheel_.ExpireOverdue();
+        busy_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
     }
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "FileCache.h"
+#include "HttpData.h"
+#include "CompressionCache.h"
+#include <fcntl.h>
+
+FileValidators FileValidators::FromStat(const struct stat& st)
+{
+    /*splitmix64的混合函数*/
+    auto mix = [](uint64_t h, uint64_t v){
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    };
+    uint64_t h = 0;
+    h = mix(h, static_cast<uint64_t>(st.st_ino));
+    h = mix(h, static_cast<uint64_t>(st.st_size));
+    h = mix(h, static_cast<uint64_t>(st.st_mtim.tv_sec));
+    h = mix(h, static_cast<uint64_t>(st.st_mtim.tv_nsec));
+
+    char etag[24];
+    snprintf(etag, sizeof etag, "\"%016llx\"", static_cast<unsigned long long>(h));
+    FileValidators validators;
+    validators.etag = etag;
+    validators.last_modified = st.st_mtim.tv_sec;
+    validators.header = "ETag: " + validators.etag + "\r\n";
+    validators.header += "Last-Modified: " + FormatHttpTime(validators.last_modified) + "\r\n";
+    return validators;
+}
+
+FileCache& FileCache::Instance()
+{
+    static FileCache cache(GlobalVar::open_file_cache_max_);
+    return cache;
+}
+
+FileCache::FileCache(size_t capacity)
+          : shard_capacity_((capacity + kShardNum - 1) / kShardNum)
+{
+    for (size_t i = 0; i < kShardNum; ++i)
+    {
+        shards_.emplace_back(std::make_unique<Shard>());
+    }
+}
+
+std::shared_ptr<const OpenFile> FileCache::Open(std::string_view name)
+{
+    std::string path = GlobalVar::resource_dir_;
+    path += name;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return nullptr;
+    auto file = std::make_shared<OpenFile>(fd);       //出错返回时自动关闭fd
+    struct stat st{};
+    if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) return nullptr;
+    file->size = st.st_size;
+    file->ino = st.st_ino;
+    file->mtime = st.st_mtim;
+
+    /*首部行的Content-Type和Content-Length字段*/
+    auto pos_dot = name.find('.');
+    file->content_type = (pos_dot == std::string_view::npos ?
+                          SourceMap::GetMime("default") : SourceMap::GetMime(std::string(name.substr(pos_dot))));
+    file->header = "Content-Type: " + file->content_type + "\r\n";
+    file->header += "Content-Length: " + std::to_string(st.st_size) + "\r\n";
+    file->header += "Accept-Ranges: bytes\r\n";
+    if(IsCompressibleType(file->content_type)) file->header += "Vary: Accept-Encoding\r\n";   //响应会随Accept-Encoding变化
+    file->validators = FileValidators::FromStat(st);
+    file->header += file->validators.header;
+    file->header += "\r\n";
+    return file;
+}
+
+std::shared_ptr<const OpenFile> FileCache::Get(std::string_view name)
+{
+    if(shard_capacity_ == 0) return Open(name);
+
+    auto& shard = ShardOf(name);
+    auto now = Clock::now();
+    std::shared_ptr<const OpenFile> stale;
+    {
+        std::unique_lock locker(shard.mutex);
+        auto it = shard.index.find(name);
+        if(it != shard.index.end())
+        {
+            auto& node = *it->second;
+            if(now - node.validated < GlobalVar::open_file_cache_valid_)
+            {
+                node.last_used = now;
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);   //移到表头
+                return node.file;
+            }
+            stale = node.file;
+        }
+    }
+
+    /*在锁外做文件系统调用，避免阻塞同一分片的其它请求。不存在的文件直接重新打开*/
+    if(stale)
+    {
+        struct stat st{};
+        std::string path = GlobalVar::resource_dir_;
+        path += name;
+        if(stat(path.c_str(), &st) == 0 && stale->SameVersion(st))
+        {
+            std::unique_lock locker(shard.mutex);
+            auto it = shard.index.find(name);
+            if(it != shard.index.end() && it->second->file == stale)
+            {
+                it->second->validated = now;
+                it->second->last_used = now;
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            }
+            return stale;
+        }
+    }
+
+    /*文件不存在时也缓存起来，例如大部分文件都没有预压缩的.gz文件，不必每次都调用open*/
+    auto file = Open(name);
+    std::unique_lock locker(shard.mutex);
+    Insert(shard, name, file, now);
+    return file;
+}
+
+void FileCache::Insert(Shard& shard, std::string_view name, std::shared_ptr<const OpenFile> file, Clock::time_point now)
+{
+    auto it = shard.index.find(name);
+    if(it != shard.index.end())
+    {
+        it->second->file = std::move(file);
+        it->second->validated = now;
+        it->second->last_used = now;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    /*淘汰长时间未使用的文件，数量仍超过上限时淘汰最久未使用的文件*/
+    while(!shard.lru.empty() &&
+          (shard.lru.size() >= shard_capacity_ || now - shard.lru.back().last_used > GlobalVar::open_file_cache_inactive_))
+    {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front({std::string(name), std::move(file), now, now});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+}
+
+void FileCache::Invalidate(std::string_view name)
+{
+    if(shard_capacity_ == 0) return;
+    auto& shard = ShardOf(name);
+    std::unique_lock locker(shard.mutex);
+    auto it = shard.index.find(name);
+    if(it == shard.index.end()) return;
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+}
+
+void FileCache::Clear()
+{
+    for (auto& shard : shards_)
+    {
+        std::unique_lock locker(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+    }
+}
@@ -1,17 +1,44 @@
 #include "HttpData.h"
 #include "Channel.h"
 #include "EventLoop.h"
+#include "StaticCache.h"
+#include "FileCache.h"
+#include "HttpRange.h"
+#include "CompressionCache.h"
+#include "HttpResponse.h"
 #include <iomanip>
-#include <sys/stat.h>
-#include <sys/mman.h>
-#include <fcntl.h>
-#include <regex>
+#include <charconv>
+
+namespace {
+
+/*!
+@brief 将非负整数以十进制追加到s末尾。
+*/
+void AppendDecimal(std::pmr::string& s, uint64_t value)
+{
+    char digits[20];
+    auto [ptr, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    s.append(digits, ptr);
+}
+
+}
+
 /*-----------------------HttpData类-------------------------*/
 HttpData::HttpData(EventLoop* sub_reactor,Channel* connfd_channel)
-                        :p_sub_reactor_(sub_reactor),
-                         p_connfd_channel_(connfd_channel),
-                         request_msg_parse_state_(RequestMsgParseState::kStart)
 {
+    Reuse(sub_reactor, connfd_channel);
+}
+
+HttpData::~HttpData()
+{
+    /*do nothing 成员变量中的raw pointers不负责管理其所指向对象的生命周期*/
+}
+
+void HttpData::Reuse(EventLoop* sub_reactor,Channel* connfd_channel)
+{
+    p_sub_reactor_ = sub_reactor;
+    p_connfd_channel_ = connfd_channel;
+    request_msg_parse_state_ = RequestMsgParseState::kStart;
     if(p_connfd_channel_)
     {
         /*设置回调函数*/
@@ -19,27 +46,25 @@ HttpData::HttpData(EventLoop* sub_reactor,Channel* connfd_channel)
         p_connfd_channel_->SetWriteHandler([this](){WriteHandler();});
         p_connfd_channel_->SetErrorHandler([this](){ErrorHandler();});
         p_connfd_channel_->SetDisconnHandler([this](){DisConndHandler();});
+        p_connfd_channel_->SetRecvHandler([this](const char* data, int n){RecvHandler(data, n);});
+        p_connfd_channel_->SetSendHandler([this](int n){SendHandler(n);});
     }
-    /*填充请求报文中方法字段与相应业务处理函数的映射*/
-    method_proc_func_["GET"]  = [this](){return ProcessGETorHEAD();};
-    method_proc_func_["HEAD"] = [this](){return ProcessGETorHEAD();};
-    method_proc_func_["POST"] = [this](){return ProcessPOST();};
-}
-
-HttpData::~HttpData()
-{
-    /*do nothing 成员变量中的raw pointers不负责管理其所指向对象的生命周期*/
+    async_io_ = p_sub_reactor_ && p_sub_reactor_->IsAsyncIo();
 }
 
-void HttpData::LinkTimer(Timer* p_timer)
+void HttpData::Recycle()
 {
-    if(!p_timer)
-    {
-        ::GetLogger()->error("can't link an empty timer");
-        return;
-    }
-    p_timer_ = p_timer;
-    p_timer_->SetExpiredHandler([this](){ExpiredHandler();});
+    p_sub_reactor_ = nullptr;
+    p_connfd_channel_ = nullptr;
+    read_in_buffer_.RetrieveAll();
+    if(read_in_buffer_.WritableBytes() > kMaxPooledBufferSize) read_in_buffer_.Shrink(Buffer::kInitialSize);
+    write_out_queue_.Clear();
+    parser_.Reset();
+    arena_.release();
+    request_msg_size_ = 0;
+    keep_alive_ = false;
+    send_inflight_ = recv_paused_ = peer_closed_ = disconnect_pending_ = false;
+    request_msg_parse_state_ = RequestMsgParseState::kStart;
 }
 
 void HttpData::ReadHandler()
@@ -48,7 +73,7 @@ void HttpData::ReadHandler()
     int fd = p_connfd_channel_->GetFd();
     bool disconnect = false;
     auto read_num = ReadData(fd, read_in_buffer_, disconnect);
-    if(read_num > 0) ::GetLogger()->debug("client {} Request:\n{}\n", fd, read_in_buffer_.c_str());
+    if(read_num > 0) ::GetLogger()->debug("client {} Request:\n{}\n", fd, read_in_buffer_.View());
     else if(read_num < 0 || disconnect)
     {
         /*read_num < 0读取数据错误可能是socket连接出了问题，这个时候最好由服务端主动断开连接*/
@@ -56,124 +81,209 @@ void HttpData::ReadHandler()
         return;
     }
 
-    /*解析http请求报文*/
-    bool finish = false;
-    bool error = false;
-    while(!finish && !error)      //finish和error同为false时才进入循环
+    /*解析http请求报文并发送响应报文*/
+    ProcessRequestMsg();
+}
+
+void HttpData::RecvHandler(const char* data, int n)
+{
+    if(disconnect_pending_) return;
+    int fd = p_connfd_channel_->GetFd();
+    if(n < 0)
     {
-        switch (request_msg_parse_state_) {
-            /*State1: 解析请求报文的请求行*/
-            case RequestMsgParseState::kStart:{
-                RequestLineParseState flag = ParseRequestLine();
-                switch (flag) {
-                    case RequestLineParseState::kParseAgain:                //未接收到完整的请求行，返回，等待下一波数据的到来
-                        return;
-                    case RequestLineParseState::kParseError:                //请求行语法错误，向客户端发送错误代码400并重置
-                        SetHttpErrorMsg(fd, 400, "Bad Request: Request line has syntax error");
-                        error = true;
-                        break;
-                    case RequestLineParseState::kParseSuccess:              //成功解析了请求行
-                        request_msg_parse_state_ = RequestMsgParseState::kRequestLineOK;
-                        break;                 //此时read_in_buffer_为：\r\n首部行 + 空行 + 实体
-                }
-            }break;
-            /*State2: 解析请求报文的首部行*/
-            case RequestMsgParseState::kRequestLineOK:{
-                HeaderLinesParseState flag = ParseHeaderLines();
-                switch (flag) {
-                    case HeaderLinesParseState::kParseAgain:                //首部行数据不完整，返回，等待下一波数据到来
-                        return;
-                    case HeaderLinesParseState::kParseError:                //首部行语法错误，向客户端发送错误代码400并重置
-                        SetHttpErrorMsg(fd, 400, "Bad Request: Header lines have syntax error");
-                        error = true;
-                        break;
-                    case HeaderLinesParseState::kParseSuccess:              //成功解析了首部行
-                        request_msg_parse_state_ = RequestMsgParseState::kHeaderLinesOK;
-                        break;                //此时read_in_buffer_为：空行 + 实体(字节数应为Content-length + 2)
-                }
-            }break;
-            /*State3: 对于POST请求，服务端要检查请求报文中的实体数据是否完整，而GET和HEAD则不用*/
-            case RequestMsgParseState::kHeaderLinesOK:{
-                if(fields_values_["method"] == "POST")
-                    request_msg_parse_state_ = RequestMsgParseState::kCheckBody;
-                else
-                    request_msg_parse_state_ = RequestMsgParseState::kAnalysisRequest;
-            }break;
-            /*State4: 查询实体数据大小并判断实体数据是否全部读到了*/
-            case RequestMsgParseState::kCheckBody:{
-                //body的两相邻报文到达的间隔不能超过client_body_timeout_，否则超时。
-                p_sub_reactor_->timewheel_.AdjustTimer(p_timer_,GlobalVar::client_body_timeout_);
-                if(fields_values_.find("Content-Length") != fields_values_.end())
-                {
-                    int content_length = std::stoi(fields_values_["Content-Length"]);
-                    if(content_length + 2 != read_in_buffer_.size())  return; //请求报文数据未全部接收，返回。
-                }
-                else
-                {
-                    //请求报文首部行中有语法错误，发送错误代码和信息并重置
-                    SetHttpErrorMsg(fd, 400, "Bad Request: Lack of argument (Content-Length)");
-                    return;
-                }
-                request_msg_parse_state_ = RequestMsgParseState::kAnalysisRequest;
-            }break;
-            /*State5: 分析客户端请求*/
-            case RequestMsgParseState::kAnalysisRequest:{
-                RequestMsgAnalysisState flag = AnalysisRequest();
-                switch (flag) {
-                    case RequestMsgAnalysisState::kAnalysisError:       //发生错误
-                        error = true;
-                        break;
-                    case RequestMsgAnalysisState::kAnalysisSuccess:     //成功
-                        request_msg_parse_state_ = RequestMsgParseState::kFinish;
-                        break;
-                }
-            }break;
-            /*State6: 请求报文全部解析完成，分析并写好了响应报文。结束while循环并向客户端发送响应报文*/
-            case RequestMsgParseState::kFinish:
-                finish = true;
-                break;
+        ::GetLogger()->error("read data from socket {} error: {}", fd, strerror(-n));
+        DisConndHandler();
+        return;
+    }
+    bool responding = !write_out_queue_.Empty();
+    if(n == 0)
+    {
+        /*对端可能只是关闭了写端，已经生成的响应报文仍然发送出去*/
+        ::GetLogger()->debug("clinet {} has close the connection", fd);
+        if(responding) peer_closed_ = true;
+        else DisConndHandler();
+        return;
+    }
+    read_in_buffer_.Append(data, n);
+    ::GetLogger()->debug("client {} Request:\n{}\n", fd, read_in_buffer_.View());
+    if(responding)
+    {
+        /*管线化的请求报文等当前响应报文发送完后再处理*/
+        if(!recv_paused_ && read_in_buffer_.ReadableBytes() > kMaxPendingInputSize)
+        {
+            p_sub_reactor_->PauseRecv(p_connfd_channel_);
+            recv_paused_ = true;
         }
+        return;
     }
-    /*发送http响应报文*/
+
+    /*解析http请求报文并发送响应报文*/
+    ProcessRequestMsg();
+}
+
+void HttpData::SendHandler(int n)
+{
+    send_inflight_ = false;
+    if(disconnect_pending_ || n < 0)
+    {
+        if(!disconnect_pending_) ::GetLogger()->error("write data to socket {} error: {}", p_connfd_channel_->GetFd(), strerror(-n));
+        disconnect_pending_ = false;
+        DisConndHandler();
+        return;
+    }
+    write_out_queue_.Retrieve(n);
     WriteHandler();
 }
 
-void HttpData::WriteHandler()
+void HttpData::ProcessRequestMsg()
 {
-    /*向连接socket写数据*/
     int fd = p_connfd_channel_->GetFd();
-    auto total_num = write_out_buffer_.size() + 1; //调用c_str函数后，会最末尾加上\0，所以发送的数据总数要加1
-    ssize_t write_sum = 0;
     while(true)
     {
-        bool full;
-        auto ret = WriteData(fd, write_out_buffer_,full);
-        if(ret < 0)                       //写数据出错，断开连接
+        /*解析http请求报文*/
+        bool finish = false;
+        bool error = false;
+        while(!finish && !error)      //finish和error同为false时才进入循环
         {
-            DisConndHandler();
-            return;
+            switch (request_msg_parse_state_) {
+                /*State1: 解析请求报文的请求行*/
+                case RequestMsgParseState::kStart:{
+                    RequestLineParseState flag = parser_.ParseRequestLine(read_in_buffer_.Peek(), read_in_buffer_.ReadableBytes());
+                    switch (flag) {
+                        case RequestLineParseState::kParseAgain:                //未接收到完整的请求行，返回，等待下一波数据的到来
+                            return;
+                        case RequestLineParseState::kParseError:                //请求行语法错误，向客户端发送错误代码400并重置
+                            SetHttpErrorMsg(fd, HttpStatus::kBadRequest, "request line has syntax error");
+                            error = true;
+                            break;
+                        case RequestLineParseState::kParseSuccess:              //成功解析了请求行
+                            request_msg_parse_state_ = RequestMsgParseState::kRequestLineOK;
+                            break;
+                    }
+                }break;
+                /*State2: 解析请求报文的首部行*/
+                case RequestMsgParseState::kRequestLineOK:{
+                    HeaderLinesParseState flag = parser_.ParseHeaderLines(read_in_buffer_.Peek(), read_in_buffer_.ReadableBytes());
+                    switch (flag) {
+                        case HeaderLinesParseState::kParseAgain:                //首部行数据不完整，返回，等待下一波数据到来
+                            return;
+                        case HeaderLinesParseState::kParseError:                //首部行语法错误，向客户端发送错误代码400并重置
+                            SetHttpErrorMsg(fd, HttpStatus::kBadRequest, "header lines have syntax error");
+                            error = true;
+                            break;
+                        case HeaderLinesParseState::kParseSuccess:              //成功解析了首部行
+                            request_msg_parse_state_ = RequestMsgParseState::kHeaderLinesOK;
+                            request_msg_size_ = parser_.HeaderEnd();
+                            keep_alive_ = EqualsIgnoreCase(GetHeader(HttpField::kConnection), "keep-alive");
+                            break;
+                    }
+                }break;
+                /*State3: 对于POST请求，服务端要检查请求报文中的实体数据是否完整，而GET和HEAD则不用*/
+                case RequestMsgParseState::kHeaderLinesOK:{
+                    if(parser_.MethodType() == HttpMethod::kPost)
+                        request_msg_parse_state_ = RequestMsgParseState::kCheckBody;
+                    else
+                        request_msg_parse_state_ = RequestMsgParseState::kAnalysisRequest;
+                }break;
+                /*State4: 查询实体数据大小并判断实体数据是否全部读到了*/
+                case RequestMsgParseState::kCheckBody:{
+                    //body的两相邻报文到达的间隔不能超过client_body_timeout_，否则超时。
+                    p_sub_reactor_->timewheel_.RefreshTimer(&timer_,GlobalVar::client_body_timeout_);
+                    auto value = GetHeader(HttpField::kContentLength);
+                    size_t content_length = 0;
+                    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), content_length);
+                    if(value.empty() || ec != std::errc() || ptr != value.data() + value.size())
+                    {
+                        //请求报文首部行中有语法错误，发送错误代码和信息并重置
+                        SetHttpErrorMsg(fd, HttpStatus::kBadRequest, "lack of argument (Content-Length)");
+                        error = true;
+                        break;
+                    }
+                    if(read_in_buffer_.ReadableBytes() - parser_.HeaderEnd() < content_length) return; //实体数据未全部接收，返回。
+                    request_msg_size_ = parser_.HeaderEnd() + content_length;
+                    request_msg_parse_state_ = RequestMsgParseState::kAnalysisRequest;
+                }break;
+                /*State5: 分析客户端请求*/
+                case RequestMsgParseState::kAnalysisRequest:{
+                    RequestMsgAnalysisState flag = AnalysisRequest();
+                    switch (flag) {
+                        case RequestMsgAnalysisState::kAnalysisError:       //发生错误
+                            error = true;
+                            break;
+                        case RequestMsgAnalysisState::kAnalysisSuccess:     //成功
+                            request_msg_parse_state_ = RequestMsgParseState::kFinish;
+                            break;
+                    }
+                }break;
+                /*State6: 请求报文全部解析完成，分析并写好了响应报文。结束while循环并向客户端发送响应报文*/
+                case RequestMsgParseState::kFinish:
+                    finish = true;
+                    break;
+            }
         }
-        write_sum += ret;
-        if(full && write_sum < total_num) //发送缓冲区已写满，但数据还未全部发送完，则注册EPOLLOUT并返回等待epoll_wait返回再回调
+        /*发送http响应报文，管线化时继续处理缓冲区中剩余的请求报文*/
+        if(!FlushResponseMsg() || read_in_buffer_.ReadableBytes() == 0) return;
+    }
+}
+
+void HttpData::WriteHandler()
+{
+    /*EPOLLOUT触发时发送剩余的响应报文，发送完毕后继续处理管线化的请求报文*/
+    if(FlushResponseMsg() && read_in_buffer_.ReadableBytes() > 0) ProcessRequestMsg();
+}
+
+bool HttpData::FlushResponseMsg()
+{
+    if(async_io_ && send_inflight_) return false;
+    /*!
+        异步I/O时把头部的内存段交给内核，MSG_WAITALL让内核在发送缓冲区满时自己等待，全部写出后才完成，
+        不需要EPOLLOUT。与发送缓冲区写满时一样取消timer，完成后由Reset重新设置。
+     */
+    int flags = async_io_ ? write_out_queue_.FillMsg(send_msg_, send_iov_.data()) : -1;
+    if(flags >= 0)
+    {
+        if(!p_sub_reactor_->SendAsync(p_connfd_channel_, &send_msg_, flags | MSG_WAITALL))
         {
-            MutexRegInOrOut(false);
-            p_sub_reactor_->timewheel_.DelTimer(p_timer_);
-            p_timer_ = nullptr;          //这里需要取消timer，避免因为发送缓冲区已满造成连接超时
-            return;
+            DisConndHandler();
+            return false;
         }
-        if(write_sum == total_num) break;
+        send_inflight_ = true;
+        p_sub_reactor_->timewheel_.DelTimer(&timer_);
+        return false;
+    }
+
+    /*向连接socket写数据，首段是文件时仍用sendfile*/
+    int fd = p_connfd_channel_->GetFd();
+    bool full = false;
+    if(WriteData(fd, write_out_queue_, full) < 0)   //写数据出错，断开连接
+    {
+        DisConndHandler();
+        return false;
+    }
+    if(full)        //发送缓冲区已写满，但数据还未全部发送完，则注册EPOLLOUT并返回等待epoll_wait返回再回调
+    {
+        MutexRegInOrOut(false);
+        p_sub_reactor_->timewheel_.DelTimer(&timer_);     //这里需要取消timer，避免因为发送缓冲区已满造成连接超时
+        return false;
     }
 
     /*发送完数据后，需删除EPOLLOUT事件并重新注册EPOLLIN事件*/
     MutexRegInOrOut(true);
 
     /*重置*/
-    Reset();
+    return Reset();
 }
 
 void HttpData::DisConndHandler()
 {
     int fd = p_connfd_channel_->GetFd();
+    /*sendmsg完成之前内核还在读输出队列中的数据，先让它以错误结束，在SendHandler中再断开连接*/
+    if(send_inflight_)
+    {
+        disconnect_pending_ = true;
+        shutdown(fd, SHUT_RDWR);
+        return;
+    }
     /*此时，需将连接socket从事件池中删除*/
     if(p_sub_reactor_->DelEpollEvent(p_connfd_channel_))
     {
@@ -187,108 +297,38 @@ void HttpData::ErrorHandler()
     DisConndHandler();
 }
 
-void HttpData::SetHttpErrorMsg(int fd, int error_num, std::string msg)
+void HttpData::SetHttpErrorMsg(int fd, HttpStatus status, std::string_view detail)
 {
-    ::GetLogger()->debug("Client {} http error: {} {}", fd, error_num, msg.c_str());
-
-    /*编写响应报文的entidy body*/
-    std::string response_body;
-    response_body += "<html><title>错误</title>";
-    response_body += "<body bgcolor=\"ffffff\">";
-    response_body += std::to_string(error_num) + msg;
-    response_body += "<hr><em> Hollow-Dai Server</em>\n</body></html>";
-
-    /*编写响应报文的header*/
-    std::string response_header;
-    response_header += "HTTP/1.1 " + std::to_string(error_num) + " "+ msg + "\r\n";
-    response_header += "Date: " + GetTime() + "\r\n";
-    response_header += "Server: Hollow-Dai\r\n";
-    response_header += "Content-Type: text/html\r\n";
-    response_header += "Connection: close\r\n";
-    response_header += "Content-Length: " + std::to_string(response_body.size()) + "\r\n";
-    response_header += "\r\n";
-    write_out_buffer_ = response_header + response_body;
+    ::GetLogger()->debug("Client {} http error: {} {}", fd, StatusLine(status).substr(9, 3), detail);
+    keep_alive_ = false;         //出错后无法确定请求报文的边界，发送完错误信息后断开连接
+
+    /*错误页面是预先生成的，只有Date需要当前时间*/
+    const auto& page = GetErrorPage(status);
+    write_out_queue_.Clear();
+    write_out_queue_.Append(page.status_line);
+    write_out_queue_.Append(HttpDate::Line());
+    write_out_queue_.Append(page.rest);
 }
 
 void HttpData::ExpiredHandler()
 {
+    /*sendmsg提交时已经取消了timer，这里只是防止修改内核还在读的输出队列*/
+    if(send_inflight_) return;
     int fd = p_connfd_channel_->GetFd();
     ::GetLogger()->debug("client {} timeout, shut it down", fd);
-    SetHttpErrorMsg(fd, 408, "Request Time-out");
-    WriteHandler();
-}
-
-RequestLineParseState HttpData::ParseRequestLine()
-{
-    /*!
-        Http请求报文的请求行的格式为：
-        请求方法|空格|URI|空格|协议版本|回车符|换行符。其中URI以‘/’开始。例如：
-        GET /index.html HTTP/1.1\r\n
-     */
-
-    /*必须要接收到完整的请求行才能开始解析*/
-    auto pos = read_in_buffer_.find("\r\n");
-    if(pos == std::string::npos) return RequestLineParseState::kParseAgain;
-
-    /*从read_in_buffer中截取出请求行*/
-    auto request_line = read_in_buffer_.substr(0,pos);
-    read_in_buffer_.erase(0,pos);        //不要把\r\n也截取了，这样解析首部行时会方便一点
-
-    /*使用正则表达式解析http请求报文的request line*/
-    std::regex r(R"(^(GET|HEAD|POST)\s(\S*)\s(HTTP\/1\.[0|1])$)");
-    std::smatch results;
-    std::regex_match(request_line,results,r);
-    if(results.empty()) return RequestLineParseState::kParseError;
-
-    /*保存method URI以及version*/
-    fields_values_["method"] = results[1];
-    fields_values_["URI"] = results[2];
-    fields_values_["version"] = results[3];
-    
-    return RequestLineParseState::kParseSuccess;
+    SetHttpErrorMsg(fd, HttpStatus::kRequestTimeout, "request time-out");
+    FlushResponseMsg();
 }
 
-HeaderLinesParseState HttpData::ParseHeaderLines()
+RequestMsgAnalysisState HttpData::AnalysisRequest()
 {
-    /*!
-        只检查每一行的格式。首部行的格式必须为"字段名：|空格|字段值|cr|lf"
-        对首部字段是否正确，字段值是否正确均不做判断。
-        另外，此时的read_in_buffer_为：\r\n首部行 + 空行 + 实体
-     */
-    auto FormatCheck = [this](std::string& target) -> bool
-    {
-        std::regex r(R"(^([[:alpha:]]\S*)\:\s(.+)$)");
-        std::smatch results;
-        std::regex_match(target,results,r);
-        if(results.empty()) return false;
-        /*保存首部字段和对应的值*/
-        fields_values_[results[1]] = results[2];
-        return true;
-    };
-
-    /*判断每个首部行的格式是否正确*/
-    decltype(read_in_buffer_.size()) pos_cr = 0,old_pos = 0;
-    while(true)
+    auto func = kMethodProcFuncs[static_cast<size_t>(parser_.MethodType())];
+    if(!func)
     {
-        old_pos = pos_cr;
-        pos_cr = read_in_buffer_.find("\r\n",pos_cr + 2);
-        if(pos_cr == std::string::npos) return HeaderLinesParseState::kParseAgain;   //接收到完整的首部行后才开始解析
-        else if(pos_cr == old_pos + 2)
-        {
-            //解析到首部行和实体之间的空行了，则说明首部行格式没问题且数据完整。此时清除已解析的header(保留空行和实体)
-            read_in_buffer_ = read_in_buffer_.substr(pos_cr);
-            break;
-        }
-        std::string header_line = read_in_buffer_.substr(old_pos+2,pos_cr-old_pos-2); //检查首部行格式
-        if(!FormatCheck(header_line)) return HeaderLinesParseState::kParseError;
+        SetHttpErrorMsg(p_connfd_channel_->GetFd(), HttpStatus::kNotImplemented, "method not implemented");
+        return RequestMsgAnalysisState::kAnalysisError;
     }
-
-    return HeaderLinesParseState::kParseSuccess;
-}
-
-RequestMsgAnalysisState HttpData::AnalysisRequest()
-{
-    return method_proc_func_[fields_values_["method"]]();
+    return (this->*func)();
 }
 
 RequestMsgAnalysisState HttpData::ProcessGETorHEAD()
@@ -297,70 +337,66 @@ RequestMsgAnalysisState HttpData::ProcessGETorHEAD()
     
     FillPartOfResponseMsg();  //编写响应报文中和请求报文中的方法字段无关的内容
 
-    /*解析客户端请求的资源名*/
-    std::string file_name = fields_values_["URI"].substr(fields_values_["URI"].find_last_of('/')+1);
+    /*解析客户端请求的资源名，直接引用读缓冲区中的数据*/
+    auto uri = parser_.Uri(read_in_buffer_.Peek());
+    auto file_name = uri.substr(uri.find_last_of('/') + 1);
     
     /*echo test*/
     if(file_name == "hello")
     {
-        std::string body = "Hello World";
-        write_out_buffer_ += std::string("Content-type: text/plain\r\n");
-        write_out_buffer_ += std::string("Content-Length: ") + std::to_string(body.size()) + "\r\n\r\n" + body;
+        static constexpr std::string_view kHeader = "Content-type: text/plain\r\nContent-Length: 11\r\n\r\n";
+        static constexpr std::string_view kBody = "Hello World";
+        write_out_queue_.Append(kHeader);
+        write_out_queue_.AppendStatic(kBody.data(), kBody.size());
         return RequestMsgAnalysisState::kAnalysisSuccess;
     }
     else if(file_name == "favicon.ico")
     {
-        write_out_buffer_ += "Content-Type: image/png\r\n";
-        write_out_buffer_ += "Content-Length: " + std::to_string(sizeof(GlobalVar::favicon)) + "\r\n";
-        write_out_buffer_ += "\r\n" + std::string(GlobalVar::favicon);
+        static const std::string kHeader = "Content-Type: image/png\r\nContent-Length: "
+                                           + std::to_string(sizeof(GlobalVar::favicon)) + "\r\n\r\n";
+        write_out_queue_.Append(kHeader);
+        write_out_queue_.AppendStatic(GlobalVar::favicon, sizeof(GlobalVar::favicon));
         return RequestMsgAnalysisState::kAnalysisSuccess;
     }
 
-    /*首部行的Content-Type字段*/
-    std::string::size_type pos_dot = file_name.find('.');
-    std::string file_type = (pos_dot == std::string::npos ?
-                            SourceMap::GetMime("default") : SourceMap::GetMime(file_name.substr(pos_dot)));  //文件类型
-
-    write_out_buffer_ += "Content-Type: " + file_type + "\r\n";
-    /*首部行的Content-Length字段*/
-    std::string dir = "../resource/" + file_name;
-    int fd = p_connfd_channel_->GetFd();
-    struct stat file{};
-    if(stat(dir.c_str(),&file) < 0)
+    /*!
+        静态文件缓存命中时直接使用渲染好的首部行，实体以共享数据的形式发送，不需要任何文件系统调用。
+     */
+    auto& cache = StaticCache::Instance();
+    if(auto cached = cache.Get(file_name))
     {
-        SetHttpErrorMsg(fd, 404, "Not Found!");
-        return RequestMsgAnalysisState::kAnalysisError;
+        return ReplyFileWithEncoding(file_name, {cached, cached->body.data(), -1, static_cast<off_t>(cached->body.size()),
+                                                 cached->content_type, cached->validators, cached->header});
     }
-    write_out_buffer_ += "Content-Length: " + std::to_string(file.st_size) + "\r\n";
-    /*首部行结束*/
+    uint64_t generation = cache.Generation();        //必须在获取文件之前获取
 
-    /*HEAD方法不需要实体*/
-    if(fields_values_["method"] == "HEAD")
-    {
-        write_out_buffer_ += "\r\n";
-        return RequestMsgAnalysisState::kAnalysisSuccess;
-    }
-    
-    /*对GET方法，打开并读取文件，然后填充报文实体*/
-    int file_fd = open(dir.c_str(),O_RDONLY,0);
-    if(file_fd < 0)
+    /*从文件描述符缓存获取文件及渲染好的首部行*/
+    auto file = FileCache::Instance().Get(file_name);
+    if(!file)
     {
-        SetHttpErrorMsg(fd, 404, "Not Found!");
+        SetHttpErrorMsg(p_connfd_channel_->GetFd(), HttpStatus::kNotFound, file_name);
         return RequestMsgAnalysisState::kAnalysisError;
     }
-    /*读取文件*/
-    void* mmap_ret = mmap(nullptr,file.st_size,PROT_READ,MAP_PRIVATE,file_fd,0);  //使用mmap避免拷贝
-    close(file_fd);
-    if(mmap_ret == (void*)-1) //读取文件出错
+
+    /*能被缓存接纳的小文件读入内存后放入缓存，并直接从缓存发送。HEAD方法不需要实体，不读取*/
+    if(parser_.MethodType() != HttpMethod::kHead && cache.WouldAdmit(file_name, file->header.size(), file->size))
     {
-        munmap(mmap_ret,file.st_size);
-        SetHttpErrorMsg(fd, 404, "Not Found!");
-        return RequestMsgAnalysisState::kAnalysisError;
+        auto cached = std::make_shared<CachedFile>();
+        cached->header = file->header;
+        cached->content_type = file->content_type;
+        cached->validators = file->validators;
+        cached->body.resize(file->size);
+        if(ReadData(file->fd.Get(), cached->body.data(), file->size, 0) == file->size)
+        {
+            cache.Insert(file_name, cached, generation);
+            return ReplyFileWithEncoding(file_name, {cached, cached->body.data(), -1, file->size,
+                                                     cached->content_type, cached->validators, cached->header});
+        }
     }
-    char* file_buffer = static_cast<char*>(mmap_ret);
-    write_out_buffer_ += "\r\n" + std::string(file_buffer,file_buffer + file.st_size);
-    munmap(mmap_ret,file.st_size);
-    return RequestMsgAnalysisState::kAnalysisSuccess;
+
+    /*文件由sendfile分多次直接从page cache发送，文件描述符由file保持打开*/
+    return ReplyFileWithEncoding(file_name, {file, nullptr, file->fd.Get(), file->size,
+                                             file->content_type, file->validators, file->header});
 }
 
 RequestMsgAnalysisState HttpData::ProcessPOST()
@@ -369,14 +405,18 @@ RequestMsgAnalysisState HttpData::ProcessPOST()
         POST方法用于客户端向服务端提交数据。这里简单将请求报文实体中的字符串
         全部转换成大写，然后发送回客户端。
      */
-     auto body = read_in_buffer_.substr(2);
-     for (auto& item : body)
+     const char* body = read_in_buffer_.Peek() + parser_.HeaderEnd();
+     size_t body_size = request_msg_size_ - parser_.HeaderEnd();
+     FillPartOfResponseMsg();
+     write_out_queue_.Append("Content-Type: text/plain\r\n");
+     write_out_queue_.Append(NumericHeader("Content-Length", body_size).View());
+     write_out_queue_.Append("\r\n");
+     /*直接转换到输出队列中，实体数据只拷贝一次*/
+     char* upper = write_out_queue_.AppendUninitialized(body_size);
+     for (size_t i = 0; i < body_size; ++i)
      {
-         item = static_cast<char>(std::toupper(static_cast<unsigned char>(item)));
+         upper[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(body[i])));
      }
-     FillPartOfResponseMsg();
-     write_out_buffer_ += std::string("Content-Type: text/plain\r\n") + "Content-Length: " + std::to_string(body.size()) + "\r\n";
-     write_out_buffer_ += "\r\n" + body;
 
      return RequestMsgAnalysisState::kAnalysisSuccess;
 }
@@ -398,49 +438,250 @@ void HttpData::MutexRegInOrOut(bool epollin)
     p_sub_reactor_->ModEpollEvent(p_connfd_channel_);
 }
 
-void HttpData::Reset()
+bool HttpData::Reset()
 {
     /*长连接则重置超时时间，短连接则关闭连接*/
-    if(fields_values_["Connection"] == "keep-alive" || fields_values_["Connection"] == "Keep-Alive")
+    if(keep_alive_ && !peer_closed_)
     {
-        auto timeout = GlobalVar::keep_alive_timeout_;
-        if(!p_timer_) p_sub_reactor_->timewheel_.AddTimer(timeout);
-        else p_sub_reactor_->timewheel_.AdjustTimer(p_timer_,timeout);
+        p_sub_reactor_->timewheel_.RefreshTimer(&timer_, GlobalVar::keep_alive_timeout_);
     }
     else
     {
         DisConndHandler();
-        return;
+        return false;
     }
-    /*重置连接信息*/
-    read_in_buffer_.clear();
-    write_out_buffer_.clear();
-    fields_values_.clear();
+    /*重置连接信息，只删除已处理的请求报文，管线化时缓冲区中可能还有下一个请求报文*/
+    read_in_buffer_.Retrieve(request_msg_size_);
+    write_out_queue_.Clear();
+    parser_.Reset();
+    arena_.release();
+    request_msg_size_ = 0;
+    keep_alive_ = false;
     request_msg_parse_state_ = RequestMsgParseState::kStart;
+    /*积压的请求报文接下来就会被处理，可以继续接收了*/
+    if(recv_paused_)
+    {
+        p_sub_reactor_->ResumeRecv(p_connfd_channel_);
+        recv_paused_ = false;
+    }
+    return true;
 }
 
-void HttpData::FillPartOfResponseMsg()
+void HttpData::FillPartOfResponseMsg(HttpStatus status)
 {
-    /*状态行*/
-    std::string status_line = fields_values_["version"] + " 200 OK\r\n";
-
-    /*首部行的Date字段*/
-    std::string header_lines;
-    header_lines += "Date: " + GetTime() + "\r\n";
-    /*首部行的Server字段*/
-    header_lines += "Server: Hollow-Dai\r\n";
-    /*首部行的Connection字段*/
-    if(fields_values_["Connection"] == "keep-alive" || fields_values_["Connection"] == "Keep-Alive")
+    /*状态行、Date以及Server和Connection字段都是渲染好的，这里只需拷贝*/
+    write_out_queue_.Clear();
+    write_out_queue_.Append(StatusLine(status));
+    write_out_queue_.Append(HttpDate::Line());
+    write_out_queue_.Append(FixedHeaderLines(keep_alive_));
+}
+
+bool HttpData::IsNotModified(const FileValidators& validators)
+{
+    /*If-None-Match使用弱比较，多个ETag以逗号分隔*/
+    auto if_none_match = GetHeader(HttpField::kIfNoneMatch);
+    if(!if_none_match.empty())
     {
-        header_lines += "Connection: keep-alive\r\n" + std::string("Keep-Alive: timeout=")
-                        + std::to_string(GlobalVar::keep_alive_timeout_.count()) + "\r\n";
+        while(!if_none_match.empty())
+        {
+            auto pos = if_none_match.find(',');
+            auto tag = if_none_match.substr(0, pos);
+            if_none_match = (pos == std::string_view::npos ? std::string_view{} : if_none_match.substr(pos + 1));
+
+            while(!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+            while(!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+            if(tag == "*") return true;
+            if(tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+            if(tag == validators.etag) return true;
+        }
+        return false;
     }
-    else
+
+    auto if_modified_since = GetHeader(HttpField::kIfModifiedSince);
+    if(if_modified_since.empty()) return false;
+    auto since = ParseHttpTime(if_modified_since);
+    return since && validators.last_modified <= *since;
+}
+
+RequestMsgAnalysisState HttpData::ReplyNotModified(const FileValidators& validators)
+{
+    FillPartOfResponseMsg(HttpStatus::kNotModified);
+    write_out_queue_.Append(validators.header);
+    write_out_queue_.Append("\r\n");
+    return RequestMsgAnalysisState::kAnalysisSuccess;
+}
+
+RequestMsgAnalysisState HttpData::ReplyFileWithEncoding(std::string_view file_name, const FileBody& body)
+{
+    auto accept_encoding = GetHeader(HttpField::kAcceptEncoding);
+    if(accept_encoding.empty() || !IsCompressibleType(body.content_type)) return ReplyFile(body);
+    unsigned codings = ParseAcceptEncoding(accept_encoding);
+    auto& compression_cache = CompressionCache::Instance();
+
+    /*优先使用预压缩的文件，br的压缩率比gzip更高*/
+    static const std::pair<ContentCoding, const char*> kPrecompressed[] = {
+        {ContentCoding::kBrotli, ".br"},
+        {ContentCoding::kGzip, ".gz"},
+    };
+    std::pmr::string compressed_name(&arena_);
+    for (const auto& [coding, suffix] : kPrecompressed)
+    {
+        if(!(codings & static_cast<unsigned>(coding))) continue;
+        compressed_name.assign(file_name);
+        compressed_name += suffix;
+        auto compressed = FileCache::Instance().Get(compressed_name);
+        if(!compressed) continue;
+        auto variant = compression_cache.GetPrecompressed(file_name, coding, *compressed, body.content_type);
+        return ReplyFile({compressed, nullptr, compressed->fd.Get(), compressed->size,
+                          variant->content_type, variant->validators, variant->header});
+    }
+
+    /*!
+        没有预压缩文件时运行时用gzip压缩。压缩在后台线程中进行，完成前先返回未压缩的实体。
+        HEAD方法不发送实体，只使用已经缓存的压缩结果，不为它提交压缩。
+     */
+    if(!(codings & static_cast<unsigned>(ContentCoding::kGzip))) return ReplyFile(body);
+    auto cached = compression_cache.GetGzip(file_name, body.validators.etag);
+    if(!cached)
+    {
+        if(parser_.MethodType() != HttpMethod::kHead)
+        {
+            compression_cache.CompressGzip(file_name, {body.holder, body.data, body.fd, body.size,
+                                                       body.content_type, body.validators});
+        }
+        return ReplyFile(body);
+    }
+    const auto& variant = *cached;
+    if(!variant) return ReplyFile(body);
+    return ReplyFile({variant, variant->body.data(), -1, static_cast<off_t>(variant->body.size()),
+                      variant->content_type, variant->validators, variant->header});
+}
+
+RequestMsgAnalysisState HttpData::ReplyFile(const FileBody& body)
+{
+    if(IsNotModified(body.validators)) return ReplyNotModified(body.validators);
+
+    /*HEAD方法不需要实体，Range只对GET方法有效*/
+    if(parser_.MethodType() == HttpMethod::kHead)
+    {
+        write_out_queue_.Append(body.header);
+        return RequestMsgAnalysisState::kAnalysisSuccess;
+    }
+
+    auto range = GetHeader(HttpField::kRange);
+    if(!range.empty() && IfRangeMatches(body.validators))
+    {
+        std::pmr::vector<ByteRange> ranges(&arena_);
+        switch(ParseByteRanges(range, body.size, ranges))
+        {
+            case RangeParseResult::kSatisfiable:
+                return ReplyPartialContent(body, ranges);
+            case RangeParseResult::kUnsatisfiable:
+            {
+                FillPartOfResponseMsg(HttpStatus::kRangeNotSatisfiable);
+                std::pmr::string header("Content-Range: bytes */", &arena_);
+                AppendDecimal(header, body.size);
+                header += "\r\nContent-Length: 0\r\n\r\n";
+                write_out_queue_.Append(header);
+                return RequestMsgAnalysisState::kAnalysisSuccess;
+            }
+            case RangeParseResult::kIgnored:
+                break;
+        }
+    }
+
+    write_out_queue_.Append(body.header);
+    AppendFileBody(body, 0, body.size);
+    return RequestMsgAnalysisState::kAnalysisSuccess;
+}
+
+bool HttpData::IfRangeMatches(const FileValidators& validators)
+{
+    auto if_range = GetHeader(HttpField::kIfRange);
+    if(if_range.empty()) return true;
+    /*If-Range中的ETag使用强比较，弱ETag永远不匹配；日期必须与Last-Modified完全相同*/
+    if(if_range.front() == '"') return if_range == validators.etag;
+    if(if_range.substr(0, 2) == "W/") return false;
+    auto date = ParseHttpTime(if_range);
+    return date && *date == validators.last_modified;
+}
+
+RequestMsgAnalysisState HttpData::ReplyPartialContent(const FileBody& body, const std::pmr::vector<ByteRange>& ranges)
+{
+    FillPartOfResponseMsg(HttpStatus::kPartialContent);
+    /*生成"Content-Range: bytes first-last/size\r\n"*/
+    auto append_content_range = [&body](std::pmr::string& s, const ByteRange& range){
+        s += "Content-Range: bytes ";
+        AppendDecimal(s, range.first);
+        s += '-';
+        AppendDecimal(s, range.last);
+        s += '/';
+        AppendDecimal(s, body.size);
+        s += "\r\n";
+    };
+
+    if(ranges.size() == 1)
     {
-        header_lines +="Connection: close\r\n";
+        const auto& range = ranges.front();
+        std::pmr::string header("Content-Type: ", &arena_);
+        header += body.content_type;
+        header += "\r\n";
+        header += NumericHeader("Content-Length", range.Length()).View();
+        append_content_range(header, range);
+        header += body.validators.header;
+        header += "\r\n";
+        write_out_queue_.Append(header);
+        AppendFileBody(body, range.first, range.Length());
+        return RequestMsgAnalysisState::kAnalysisSuccess;
     }
 
-    write_out_buffer_ = status_line + header_lines;
+    /*!
+        多个区间时以multipart/byteranges的形式返回，各部分的首部需要先生成才能计算出Content-Length。
+        各部分的实体与单个区间时一样直接从缓存或文件发送。
+     */
+    static thread_local uint64_t boundary_seq = 0;
+    std::pmr::string boundary("HollowDai", &arena_);
+    boundary += std::string_view(body.validators.etag).substr(1, 8);
+    AppendDecimal(boundary, ++boundary_seq);
+    std::pmr::vector<std::pmr::string> part_headers(&arena_);
+    part_headers.reserve(ranges.size());
+    size_t content_length = 0;
+    for (const auto& range : ranges)
+    {
+        auto& part = part_headers.emplace_back("\r\n--");
+        part += boundary;
+        part += "\r\nContent-Type: ";
+        part += body.content_type;
+        part += "\r\n";
+        append_content_range(part, range);
+        part += "\r\n";
+        content_length += part.size() + range.Length();
+    }
+    std::pmr::string closing("\r\n--", &arena_);
+    closing += boundary;
+    closing += "--\r\n";
+    content_length += closing.size();
+
+    std::pmr::string header("Content-Type: multipart/byteranges; boundary=", &arena_);
+    header += boundary;
+    header += "\r\n";
+    header += NumericHeader("Content-Length", content_length).View();
+    header += body.validators.header;
+    header += "\r\n";
+    write_out_queue_.Append(header);
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        write_out_queue_.Append(part_headers[i]);
+        AppendFileBody(body, ranges[i].first, ranges[i].Length());
+    }
+    write_out_queue_.Append(closing);
+    return RequestMsgAnalysisState::kAnalysisSuccess;
+}
+
+void HttpData::AppendFileBody(const FileBody& body, off_t offset, size_t n)
+{
+    if(body.data) write_out_queue_.AppendShared(body.holder, body.data + offset, n);
+    else write_out_queue_.AppendFile(body.holder, body.fd, offset, n);
 }
 
 /*-----------------------SourceMap类-------------------------*/
@@ -0,0 +1,102 @@
+#include "HttpHeaders.h"
+
+namespace {
+
+constexpr char ToLower(char c) {return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;}
+
+constexpr size_t kHashTableSize = 64;                  //必须为2的幂
+
+constexpr size_t HashFieldName(std::string_view name, uint32_t seed)
+{
+    if(name.empty()) return 0;
+    uint32_t h = seed;
+    h = h * 31 + static_cast<uint32_t>(name.size());
+    h = h * 31 + static_cast<unsigned char>(ToLower(name.front()));
+    h = h * 31 + static_cast<unsigned char>(ToLower(name[name.size() / 2]));
+    h = h * 31 + static_cast<unsigned char>(ToLower(name.back()));
+    return (h ^ (h >> 11)) & (kHashTableSize - 1);
+}
+
+/*!
+@brief 在编译期寻找一个使所有常用字段名的哈希值互不相同的种子。
+*/
+constexpr uint32_t FindPerfectSeed()
+{
+    for (uint32_t seed = 1; seed < 100000; ++seed)
+    {
+        std::array<bool, kHashTableSize> used{};
+        bool ok = true;
+        for (auto name : kHttpFieldNames)
+        {
+            auto h = HashFieldName(name, seed);
+            if(used[h])
+            {
+                ok = false;
+                break;
+            }
+            used[h] = true;
+        }
+        if(ok) return seed;
+    }
+    return 0;
+}
+
+constexpr uint32_t kPerfectSeed = FindPerfectSeed();
+static_assert(kPerfectSeed != 0, "no perfect hash seed for kHttpFieldNames");
+
+constexpr std::array<HttpField, kHashTableSize> MakeFieldHashTable()
+{
+    std::array<HttpField, kHashTableSize> table{};
+    for (auto& item : table) item = HttpField::kUnknown;
+    for (size_t i = 0; i < kKnownFieldNum; ++i)
+    {
+        table[HashFieldName(kHttpFieldNames[i], kPerfectSeed)] = static_cast<HttpField>(i);
+    }
+    return table;
+}
+
+constexpr std::array<HttpField, kHashTableSize> kFieldHashTable = MakeFieldHashTable();
+
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs)
+{
+    if(lhs.size() != rhs.size()) return false;
+    for (size_t i = 0; i < lhs.size(); ++i)
+    {
+        if(ToLower(lhs[i]) != ToLower(rhs[i])) return false;
+    }
+    return true;
+}
+
+HttpField LookupHttpField(std::string_view name)
+{
+    HttpField field = kFieldHashTable[HashFieldName(name, kPerfectSeed)];
+    if(field == HttpField::kUnknown) return field;
+    return EqualsIgnoreCase(name, kHttpFieldNames[static_cast<size_t>(field)]) ? field : HttpField::kUnknown;
+}
+
+bool HttpHeaderTable::Add(std::string_view name_view, StrSpan name, StrSpan value)
+{
+    if(size_ == kMaxFieldNum) return false;
+    entries_[size_++] = {name, value};
+
+    HttpField field = LookupHttpField(name_view);
+    if(field != HttpField::kUnknown)
+    {
+        auto& index = known_[static_cast<size_t>(field)];
+        if(!index) index = static_cast<uint8_t>(size_);
+    }
+    return true;
+}
+
+std::string_view HttpHeaderTable::Find(const char* base, std::string_view name) const
+{
+    HttpField field = LookupHttpField(name);
+    if(field != HttpField::kUnknown) return Get(base, field);
+    for (size_t i = 0; i < size_; ++i)
+    {
+        if(EqualsIgnoreCase(entries_[i].name.View(base), name)) return entries_[i].value.View(base);
+    }
+    return {};
+}
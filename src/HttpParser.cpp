@@ -0,0 +1,174 @@
+#include "HttpParser.h"
+#include "CharScanner.h"
+
+namespace {
+
+inline bool IsWhiteSpace(char c) {return c == ' ' || c == '\t';}
+
+}
+
+HttpMethod ParseHttpMethod(std::string_view method)
+{
+    if(method == "GET") return HttpMethod::kGet;
+    if(method == "HEAD") return HttpMethod::kHead;
+    if(method == "POST") return HttpMethod::kPost;
+    return HttpMethod::kUnknown;
+}
+
+int HttpRequestParser::ConsumeLineEnd(const char* data, size_t len)
+{
+    if(scan_pos_ == len) return 0;
+    if(data[scan_pos_] == '\n')         //容忍只有\n的行结束符
+    {
+        ++scan_pos_;
+        return 1;
+    }
+    if(data[scan_pos_] != '\r') return -1;
+    if(scan_pos_ + 1 == len) return 0;
+    if(data[scan_pos_ + 1] != '\n') return -1;
+    scan_pos_ += 2;
+    return 1;
+}
+
+RequestLineParseState HttpRequestParser::ParseRequestLine(const char* data, size_t len)
+{
+    while(true)
+    {
+        /*数据不完整时，请求行过长视为语法错误，避免接收缓冲区无限增长*/
+        if(scan_pos_ == len)
+        {
+            if(scan_pos_ - line_start_ > kMaxRequestLineSize) return RequestLineParseState::kParseError;
+            return RequestLineParseState::kParseAgain;
+        }
+
+        switch (line_state_) {
+            case LineState::kLineStart:{
+                /*忽略请求行之前的空行*/
+                if(data[scan_pos_] == '\r' || data[scan_pos_] == '\n')
+                {
+                    int ret = ConsumeLineEnd(data, len);
+                    if(ret < 0) return RequestLineParseState::kParseError;
+                    if(ret == 0) return RequestLineParseState::kParseAgain;
+                    line_start_ = scan_pos_;
+                    break;
+                }
+                field_start_ = scan_pos_;
+                line_state_ = LineState::kMethod;
+            }break;
+            /*方法字段，其后必须紧跟一个空格*/
+            case LineState::kMethod:{
+                scan_pos_ += ScanTokenChars(data + scan_pos_, len - scan_pos_);
+                if(scan_pos_ == len) break;
+                if(scan_pos_ == field_start_ || data[scan_pos_] != ' ') return RequestLineParseState::kParseError;
+                method_ = {field_start_, scan_pos_ - field_start_};
+                method_type_ = ParseHttpMethod(method_.View(data));
+                field_start_ = ++scan_pos_;
+                line_state_ = LineState::kUri;
+            }break;
+            /*URI，其后必须紧跟一个空格*/
+            case LineState::kUri:{
+                scan_pos_ += ScanUriChars(data + scan_pos_, len - scan_pos_);
+                if(scan_pos_ == len) break;
+                if(scan_pos_ == field_start_ || data[scan_pos_] != ' ') return RequestLineParseState::kParseError;
+                uri_ = {field_start_, scan_pos_ - field_start_};
+                field_start_ = ++scan_pos_;
+                line_state_ = LineState::kVersion;
+            }break;
+            /*协议版本，只支持HTTP/1.0以及HTTP/1.1*/
+            case LineState::kVersion:{
+                static const size_t kVersionSize = 8;
+                if(len - field_start_ < kVersionSize)
+                {
+                    scan_pos_ = len;
+                    break;
+                }
+                std::string_view version(data + field_start_, kVersionSize);
+                if(version != "HTTP/1.1" && version != "HTTP/1.0") return RequestLineParseState::kParseError;
+                version_ = {field_start_, kVersionSize};
+                scan_pos_ = field_start_ + kVersionSize;
+                line_state_ = LineState::kLineEnd;
+            }break;
+            case LineState::kLineEnd:{
+                int ret = ConsumeLineEnd(data, len);
+                if(ret < 0) return RequestLineParseState::kParseError;
+                if(ret == 0) return RequestLineParseState::kParseAgain;
+                line_start_ = scan_pos_;
+                line_state_ = LineState::kLineStart;
+                return RequestLineParseState::kParseSuccess;
+            }
+            default:
+                return RequestLineParseState::kParseError;
+        }
+    }
+}
+
+HeaderLinesParseState HttpRequestParser::ParseHeaderLines(const char* data, size_t len)
+{
+    while(true)
+    {
+        if(scan_pos_ == len)
+        {
+            if(scan_pos_ > kMaxHeaderSize) return HeaderLinesParseState::kParseError;
+            return HeaderLinesParseState::kParseAgain;
+        }
+
+        switch (line_state_) {
+            case LineState::kLineStart:{
+                /*解析到首部行和实体之间的空行了，说明首部行格式没问题且数据完整*/
+                if(data[scan_pos_] == '\r' || data[scan_pos_] == '\n')
+                {
+                    int ret = ConsumeLineEnd(data, len);
+                    if(ret < 0) return HeaderLinesParseState::kParseError;
+                    if(ret == 0) return HeaderLinesParseState::kParseAgain;
+                    line_start_ = header_end_ = scan_pos_;
+                    return HeaderLinesParseState::kParseSuccess;
+                }
+                field_start_ = scan_pos_;
+                line_state_ = LineState::kFieldName;
+            }break;
+            /*字段名，其后必须紧跟冒号*/
+            case LineState::kFieldName:{
+                scan_pos_ += ScanTokenChars(data + scan_pos_, len - scan_pos_);
+                if(scan_pos_ == len) break;
+                if(scan_pos_ == field_start_ || data[scan_pos_] != ':') return HeaderLinesParseState::kParseError;
+                field_name_ = {field_start_, scan_pos_ - field_start_};
+                field_start_ = ++scan_pos_;
+                line_state_ = LineState::kFieldValue;
+            }break;
+            /*字段值，扫描到控制字符为止(通常即为\r)，并去掉首尾的空白字符*/
+            case LineState::kFieldValue:{
+                scan_pos_ += ScanFieldValueChars(data + scan_pos_, len - scan_pos_);
+                if(scan_pos_ == len) break;
+                size_t value_begin = field_start_, value_end = scan_pos_;
+                while(value_begin < value_end && IsWhiteSpace(data[value_begin])) ++value_begin;
+                while(value_end > value_begin && IsWhiteSpace(data[value_end - 1])) --value_end;
+                if(!headers_.Add(field_name_.View(data), field_name_, StrSpan{value_begin, value_end - value_begin}))
+                    return HeaderLinesParseState::kParseError;
+                line_state_ = LineState::kLineEnd;
+            }break;
+            /*字段值中出现了\r\n以外的控制字符时，这里会返回错误*/
+            case LineState::kLineEnd:{
+                int ret = ConsumeLineEnd(data, len);
+                if(ret < 0) return HeaderLinesParseState::kParseError;
+                if(ret == 0) return HeaderLinesParseState::kParseAgain;
+                line_start_ = scan_pos_;
+                line_state_ = LineState::kLineStart;
+            }break;
+            default:
+                return HeaderLinesParseState::kParseError;
+        }
+    }
+}
+
+void HttpRequestParser::Reset()
+{
+    line_state_ = LineState::kLineStart;
+    line_start_ = 0;
+    scan_pos_ = 0;
+    field_start_ = 0;
+    field_name_ = StrSpan{};
+    header_end_ = 0;
+    method_ = uri_ = version_ = StrSpan{};
+    method_type_ = HttpMethod::kUnknown;
+    headers_.Clear();
+}
@@ -0,0 +1,75 @@
+#include "HttpRange.h"
+#include "HttpHeaders.h"
+#include <charconv>
+
+namespace {
+
+std::string_view TrimOws(std::string_view s)
+{
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+/*!
+@brief 解析非负整数，整个字符串都必须是数字。
+*/
+bool ParseOffset(std::string_view s, off_t& value)
+{
+    if(s.empty()) return false;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && ptr == s.data() + s.size() && value >= 0;
+}
+
+}
+
+RangeParseResult ParseByteRanges(std::string_view value, off_t size, std::pmr::vector<ByteRange>& ranges)
+{
+    ranges.clear();
+    constexpr std::string_view kUnit = "bytes=";
+    if(value.size() < kUnit.size() || !EqualsIgnoreCase(value.substr(0, kUnit.size()), kUnit))
+    {
+        return RangeParseResult::kIgnored;
+    }
+    value.remove_prefix(kUnit.size());
+
+    size_t spec_num = 0;
+    while(!value.empty())
+    {
+        auto pos = value.find(',');
+        auto spec = TrimOws(value.substr(0, pos));
+        value = (pos == std::string_view::npos ? std::string_view{} : value.substr(pos + 1));
+        if(spec.empty()) continue;                                 //允许空的列表元素
+        if(++spec_num > kMaxRangeNum) return RangeParseResult::kIgnored;
+
+        auto dash = spec.find('-');
+        if(dash == std::string_view::npos) return RangeParseResult::kIgnored;
+        auto first_text = spec.substr(0, dash);
+        auto last_text = spec.substr(dash + 1);
+
+        ByteRange range;
+        if(first_text.empty())
+        {
+            /*"-suffix_length"：最后suffix_length个字节*/
+            off_t suffix_length = 0;
+            if(!ParseOffset(last_text, suffix_length)) return RangeParseResult::kIgnored;
+            if(suffix_length == 0 || size == 0) continue;
+            range.first = suffix_length < size ? size - suffix_length : 0;
+            range.last = size - 1;
+        }
+        else
+        {
+            if(!ParseOffset(first_text, range.first)) return RangeParseResult::kIgnored;
+            if(last_text.empty()) range.last = size - 1;
+            else
+            {
+                if(!ParseOffset(last_text, range.last) || range.last < range.first) return RangeParseResult::kIgnored;
+                if(range.last >= size) range.last = size - 1;
+            }
+            if(range.first >= size) continue;                      //区间不可满足
+        }
+        ranges.push_back(range);
+    }
+    if(spec_num == 0) return RangeParseResult::kIgnored;
+    return ranges.empty() ? RangeParseResult::kUnsatisfiable : RangeParseResult::kSatisfiable;
+}
@@ -0,0 +1,81 @@
+#include "HttpResponse.h"
+#include "Utility.h"
+#include <charconv>
+
+thread_local char HttpDate::line_[HttpDate::kLineSize + 1]{};
+thread_local time_t HttpDate::seconds_ = 0;
+
+void HttpDate::Refresh(time_t now)
+{
+    if(now == seconds_) return;
+    struct tm time_info{};
+    gmtime_r(&now, &time_info);
+    /*格式固定为37个字节，strftime额外写入结尾的'\0'*/
+    strftime(line_, sizeof line_, "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &time_info);
+    seconds_ = now;
+}
+
+std::string_view FixedHeaderLines(bool keep_alive)
+{
+    static const std::string kKeepAlive = "Server: Hollow-Dai\r\nConnection: keep-alive\r\nKeep-Alive: timeout="
+                                          + std::to_string(GlobalVar::keep_alive_timeout_.count()) + "\r\n";
+    static constexpr std::string_view kClose = "Server: Hollow-Dai\r\nConnection: close\r\n";
+    return keep_alive ? std::string_view(kKeepAlive) : kClose;
+}
+
+namespace {
+
+struct ErrorPageTable{
+    std::string rests[kHttpStatusNum];
+    ErrorPage pages[kHttpStatusNum];
+
+    ErrorPageTable()
+    {
+        static const std::pair<HttpStatus, const char*> kMessages[] = {
+            {HttpStatus::kBadRequest, "400 Bad Request"},
+            {HttpStatus::kNotFound, "404 Not Found!"},
+            {HttpStatus::kRequestTimeout, "408 Request Time-out"},
+            {HttpStatus::kNotImplemented, "501 Not Implemented"},
+            {HttpStatus::kServiceUnavailable, "503 Service Unavailable"},
+        };
+        for (const auto& [status, message] : kMessages)
+        {
+            std::string body = "<html><title>错误</title>";
+            body += "<body bgcolor=\"ffffff\">";
+            body += message;
+            body += "<hr><em> Hollow-Dai Server</em>\n</body></html>";
+
+            auto index = static_cast<size_t>(status);
+            auto& rest = rests[index];
+            rest = "Server: Hollow-Dai\r\n";
+            rest += "Content-Type: text/html\r\n";
+            rest += "Connection: close\r\n";
+            rest += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+            rest += body;
+            pages[index] = {StatusLine(status), rest};
+        }
+    }
+};
+
+}
+
+const ErrorPage& GetErrorPage(HttpStatus status)
+{
+    static const ErrorPageTable kTable;
+    const auto& page = kTable.pages[static_cast<size_t>(status)];
+    return page.rest.empty() ? kTable.pages[static_cast<size_t>(HttpStatus::kBadRequest)] : page;
+}
+
+NumericHeader::NumericHeader(std::string_view name, uint64_t value)
+{
+    /*name都是代码中的常量，不会超出缓冲区，数字最多20位*/
+    assert(name.size() + 24 <= sizeof buffer_);
+    memcpy(buffer_, name.data(), name.size());
+    size_ = name.size();
+    buffer_[size_++] = ':';
+    buffer_[size_++] = ' ';
+    auto [ptr, ec] = std::to_chars(buffer_ + size_, buffer_ + sizeof buffer_, value);
+    size_ = ptr - buffer_;
+    buffer_[size_++] = '\r';
+    buffer_[size_++] = '\n';
+}
@@ -3,9 +3,13 @@
 #include "HttpData.h"
 #include "Utility.h"
 #include "EventLoop.h"
+#include "StaticCache.h"
+#include "HttpResponse.h"
+#include "ObjectPool.h"
+#include <sys/uio.h>
 
 HttpServer::HttpServer(int port, EventLoop* main_reactor,ThreadPool* sub_thread_pool)
-            : listenfd_(BindAndListen(port)), 
+            : listenfd_(BindAndListen(port, GlobalVar::reuse_port_)), 
               p_main_reactor_(main_reactor), 
               p_sub_thread_pool_(sub_thread_pool),
               p_listen_channel_(new Channel(listenfd_, false))
@@ -28,13 +32,23 @@ HttpServer::~HttpServer()
 
 void HttpServer::Start()
 {
-    /*对监听socket监听可读以及异常事件*/
-    p_listen_channel_->SetEvents(EPOLLIN | EPOLLERR);
-    p_listen_channel_->SetReadHandler([this] { NewConnHandler(); });
-    p_listen_channel_->SetErrorHandler([this]{ ErrorHandler(); });
+    /*!
+        默认由MainReactor监听listenfd_并将连接socket分发给SubReactor。SO_REUSEPORT模式下每个SubReactor
+        都有自己的监听socket(listenfd_属于第一个SubReactor)，由内核把新连接分散到各个监听socket上，
+        连接在accept它的SubReactor中处理，不需要跨线程传递。
+     */
+    ::GetLogger()->info("event loop backend: {}", p_main_reactor_->GetPollerName());
+    bool reuse_port = GlobalVar::reuse_port_;
+    if(!reuse_port)
+    {
+        AddListenChannel(p_main_reactor_, p_listen_channel_, nullptr);
+    }
 
-    /*将listen_channel加入MainReactor中进行监听*/
-    p_main_reactor_->AddEpollEvent(p_listen_channel_);
+    /*静态文件缓存通过inotify监听资源目录的变化，也由MainReactor监听*/
+    if(auto watch_channel = StaticCache::Instance().WatchDirectory(GlobalVar::resource_dir_))
+    {
+        p_main_reactor_->AddEpollEvent(watch_channel);
+    }
 
     /*构造SubReactor并开启事件循环*/
     auto sub_reactor_num = p_sub_thread_pool_->size();
@@ -42,91 +56,149 @@ void HttpServer::Start()
     {
         /*HttpServer和ThreadPool需要共享SubReactor对象，故这里使用shared_ptr*/
         auto sub_reactor = std::make_shared<EventLoop>();
-        tickfds_.emplace_back(sub_reactor->timewheel_.tick_fd_[1]);     //获取SubReactor的tickfd的写端文件描述符
+        if(reuse_port)
+        {
+            /*事件循环开始之前添加，此时还没有其它线程访问它*/
+            int listenfd = (i == 0 ? listenfd_ : BindAndListen(port_, true));
+            if(listenfd == -1 || SetNonBlocking(listenfd) < 0) exit(-1);
+            auto listen_channel = (i == 0 ? p_listen_channel_ : new Channel(listenfd, false));
+            AddListenChannel(sub_reactor.get(), listen_channel, sub_reactor.get());
+        }
         p_sub_thread_pool_->AddTaskToPool([=](){sub_reactor->StartLoop();});
         sub_reactors_.emplace_back(sub_reactor);
     }
+
+    /*事件循环开始之前创建，MainReactor收到新连接时一定已经存在*/
+    if(!reuse_port)
+    {
+        std::vector<EventLoop*> reactors;
+        for (auto& sub_reactor : sub_reactors_) reactors.push_back(sub_reactor.get());
+        balancer_ = LoadBalancer::Create(GlobalVar::balance_policy_, std::move(reactors));
+    }
 }
 
 void HttpServer::Quit()
 {
-    p_main_reactor_->QuitLoop();
-    for (auto& sub_reactors : sub_reactors_)
+    /*由各个事件循环所在的线程自己断开连接*/
+    p_main_reactor_->RunInLoop([main_reactor = p_main_reactor_](){main_reactor->QuitLoop();});
+    std::vector<std::future<void>> done;
+    for (auto& sub_reactor : sub_reactors_)
     {
-        sub_reactors->QuitLoop();
+        auto promise = std::make_shared<std::promise<void>>();
+        done.emplace_back(promise->get_future());
+        sub_reactor->RunInLoop([sub_reactor, promise](){
+            sub_reactor->QuitLoop();
+            promise->set_value();
+        });
     }
+    for (auto& future : done)
+    {
+        /*SubReactor卡在某个回调中时不无限等待*/
+        future.wait_for(std::chrono::seconds(1));
+    }
+}
+
+void HttpServer::AddListenChannel(EventLoop* loop, Channel* listen_channel, EventLoop* reactor)
+{
+    int listenfd = listen_channel->GetFd();
+    listen_channel->SetEvents(EPOLLIN | EPOLLERR);
+    listen_channel->SetReadHandler([this, listenfd, reactor] { NewConnHandler(listenfd, reactor); });
+    listen_channel->SetAcceptHandler([this, reactor](int connfd) { AcceptHandler(connfd, reactor); });
+    listen_channel->SetErrorHandler([this]{ ErrorHandler(); });
+    /*Poller支持异步I/O时由multishot accept接受连接，否则监听EPOLLIN*/
+    if(!loop->AddAcceptor(listen_channel)) loop->AddEpollEvent(listen_channel);
 }
 
-void HttpServer::NewConnHandler()
+void HttpServer::NewConnHandler(int listenfd, EventLoop* reactor)
 {
     /*从监听队列中接受一个连接*/
     sockaddr_in client_addr;
     socklen_t client_addr_len = sizeof client_addr;
     while(true)
     {
-        int connfd = accept(listenfd_,reinterpret_cast<sockaddr*>(&client_addr),&client_addr_len);
+        int connfd = accept(listenfd,reinterpret_cast<sockaddr*>(&client_addr),&client_addr_len);
         if(connfd < 0)
         {
             if(errno != EAGAIN && errno != EWOULDBLOCK)
                 ::GetLogger()->error("accept error: {}", strerror(errno));
             return;
         }
-        //限制服务器的最大并发连接数
-        if(GlobalVar::GetTotalUserNum() >= GlobalVar::kMaxUserNum)
-        {
-            ::GetLogger()->warn("max user number limit");
-            close(connfd);
-            return;
-        }
-        GlobalVar::IncTotalUserNum();
-
         if(SetNonBlocking(connfd) < 0)
         {
             printf("set non blocking failed\n");
-            return;
+            close(connfd);
+            continue;
         }
-        SetSocketNoDelay(connfd);
+        DispatchConnection(connfd, client_addr, reactor);
+    }
+}
 
-        /*将连接socket分发给SubReactor*/
-        auto connfd_channel = new Channel(connfd, true);
-        /*!
-            Http server的连接sokcet需要监听可读、可写、断开连接以及错误事件。
-            但是需要注意的是，不要一开始就注册可写事件，因为只要connfd只要不是阻塞的它就是可写的。
-            因此，需要在完整读取了客户端的数据之后再注册可写事件，否则会一直触发可写事件。
-            这里connfd_channel的生命周期交由SubReactor管理。
-         */
-        connfd_channel->SetEvents(EPOLLIN | EPOLLRDHUP | EPOLLERR);
+void HttpServer::AcceptHandler(int connfd, EventLoop* reactor)
+{
+    if(connfd < 0)
+    {
+        ::GetLogger()->error("accept error: {}", strerror(-connfd));
+        return;
+    }
+    /*multishot accept不返回客户端地址，只有分发策略用到时才查询。连接socket已经是非阻塞的*/
+    sockaddr_in client_addr{};
+    if(!reactor && balancer_->NeedsClientAddress())
+    {
+        socklen_t client_addr_len = sizeof client_addr;
+        getpeername(connfd, reinterpret_cast<sockaddr*>(&client_addr), &client_addr_len);
+    }
+    DispatchConnection(connfd, client_addr, reactor);
+}
 
-        //将连接socket分发给事件最少的SubReactor
-        int smallest_num = sub_reactors_[0]->GetConnectionNum();
-        unsigned long index = 0;
-        std::vector<int> num_of_each;
-        for (unsigned long i = 0; i < sub_reactors_.size(); ++i)
-        {
-            int num =  sub_reactors_[i]->GetConnectionNum();
-            num_of_each.push_back(num);
-            if( num < smallest_num)
-            {
-                smallest_num = num;
-                index = i;
-            }
-        }
-        //必须先设置Holder再将该连接socket加入到事件池中
-        connfd_channel->SetHolder(new HttpData(sub_reactors_[index].get(),connfd_channel));
-        if(sub_reactors_[index]->AddEpollEvent(connfd_channel))
-        {
-            //::GetLogger()->debug("new connection {} handled by subreactor {}", connfd, index);
-            ++num_of_each[index];
-        }
+void HttpServer::DispatchConnection(int connfd, const sockaddr_in& client_addr, EventLoop* reactor)
+{
+    //限制服务器的最大并发连接数
+    if(GlobalVar::GetTotalUserNum() >= GlobalVar::kMaxUserNum)
+    {
+        ::GetLogger()->warn("max user number limit");
+        /*连接刚建立，发送缓冲区是空的，预先生成的503页面可以一次写完*/
+        const auto& page = GetErrorPage(HttpStatus::kServiceUnavailable);
+        auto date = HttpDate::Line();                      //每个EventLoop(包括MainReactor)的tick都会刷新Date
+        iovec vec[3] = {{const_cast<char*>(page.status_line.data()), page.status_line.size()},
+                        {const_cast<char*>(date.data()), date.size()},
+                        {const_cast<char*>(page.rest.data()), page.rest.size()}};
+        msghdr msg{};
+        msg.msg_iov = vec;
+        msg.msg_iovlen = 3;
+        sendmsg(connfd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        close(connfd);
+        return;
+    }
+    GlobalVar::IncTotalUserNum();
+    /*TCP_NODELAY已经在监听socket上设置，连接socket会继承，不需要每个连接再调用一次setsockopt*/
+
+    //SO_REUSEPORT模式下由accept的SubReactor自己处理，否则按分发策略选择SubReactor
+    //每个连接单独选择，不能写回reactor，否则一次accept循环中后面的连接都会分给同一个SubReactor
+    EventLoop* target = reactor ? reactor : balancer_->Select(client_addr);
+    target->AddConnectionNum(1);             //分发时就计入，同一批连接的后续选择能看到它
 
-        /*打印当前每个SubReactor的连接数量*/
-        for (int i = 0; i < num_of_each.size(); ++i)
+    /*!
+        Channel和HttpData在SubReactor的线程中从它的对象池取出，关闭连接时也放回同一个对象池。
+        Http server的连接sokcet需要监听可读、可写、断开连接以及错误事件。
+        但是需要注意的是，不要一开始就注册可写事件，因为只要connfd只要不是阻塞的它就是可写的。
+        因此，需要在完整读取了客户端的数据之后再注册可写事件，否则会一直触发可写事件。
+        这里connfd_channel的生命周期交由SubReactor管理。
+     */
+    target->RunInLoop([target, connfd](){
+        auto connfd_channel = ObjectPool<Channel>::Acquire(connfd, true);
+        connfd_channel->SetEvents(EPOLLIN | EPOLLRDHUP | EPOLLERR);
+        //必须先设置Holder再将该连接socket加入到事件池中
+        connfd_channel->SetHolder(ObjectPool<HttpData>::Acquire(target, connfd_channel));
+        if(!target->AddEpollEvent(connfd_channel))
         {
-            //::GetLogger()->debug("Subreactor {} is handling {} connections", i, num_of_each[i]);
+            ObjectPool<HttpData>::Release(connfd_channel->GetHolder());
+            ObjectPool<Channel>::Release(connfd_channel);
+            target->AddConnectionNum(-1);
+            GlobalVar::DecTotalUserNum();
         }
+    });
 
-        ::GetLogger()->info("New connection {}, current user number: {}", connfd, GlobalVar::GetTotalUserNum());
-    }
+    ::GetLogger()->info("New connection {}, current user number: {}", connfd, GlobalVar::GetTotalUserNum());
 }
 
 void HttpServer::ErrorHandler()
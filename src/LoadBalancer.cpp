@@ -0,0 +1,150 @@
+#include "LoadBalancer.h"
+#include "EventLoop.h"
+
+namespace {
+
+class LeastConnBalancer : public LoadBalancer {
+public:
+    using LoadBalancer::LoadBalancer;
+
+    EventLoop* Select(const sockaddr_in&) override
+    {
+        EventLoop* selected = reactors_[0];
+        int smallest_num = selected->GetConnectionNum();
+        for (auto reactor : reactors_)
+        {
+            int num = reactor->GetConnectionNum();
+            if(num < smallest_num)
+            {
+                smallest_num = num;
+                selected = reactor;
+            }
+        }
+        return selected;
+    }
+};
+
+class RoundRobinBalancer : public LoadBalancer {
+private:
+    size_t next_ = 0;
+public:
+    using LoadBalancer::LoadBalancer;
+
+    EventLoop* Select(const sockaddr_in&) override
+    {
+        EventLoop* selected = reactors_[next_];
+        if(++next_ == reactors_.size()) next_ = 0;
+        return selected;
+    }
+};
+
+class PowerOfTwoBalancer : public LoadBalancer {
+private:
+    uint64_t state_ = 0x9e3779b97f4a7c15ULL;     //xorshift64的状态，只由MainReactor访问
+
+    size_t Random()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<size_t>(state_ % reactors_.size());
+    }
+public:
+    using LoadBalancer::LoadBalancer;
+
+    /*!
+    @brief 只比较两个随机的SubReactor，负载几乎与扫描全部一样均衡，但开销与SubReactor数量无关。
+    */
+    EventLoop* Select(const sockaddr_in&) override
+    {
+        if(reactors_.size() == 1) return reactors_[0];
+        size_t first = Random();
+        size_t second = Random();
+        if(second == first) second = (first + 1) % reactors_.size();
+        EventLoop* a = reactors_[first];
+        EventLoop* b = reactors_[second];
+        return a->GetConnectionNum() <= b->GetConnectionNum() ? a : b;
+    }
+};
+
+class IpHashBalancer : public LoadBalancer {
+public:
+    using LoadBalancer::LoadBalancer;
+
+    /*!
+    @brief 同一客户端的连接总在同一个SubReactor，该线程的缓存(例如CPU cache)更容易命中。
+    */
+    EventLoop* Select(const sockaddr_in& client) override
+    {
+        /*murmur3的fmix32，让相邻的IP也能均匀分布*/
+        uint32_t h = client.sin_addr.s_addr;
+        h ^= h >> 16;
+        h *= 0x85ebca6bU;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35U;
+        h ^= h >> 16;
+        return reactors_[h % reactors_.size()];
+    }
+
+    bool NeedsClientAddress() const override {return true;}
+};
+
+class LeastBusyBalancer : public LoadBalancer {
+public:
+    using LoadBalancer::LoadBalancer;
+
+    /*!
+    @brief 连接数相同的SubReactor负载可能相差很大(例如正在发送大文件)，忙碌时间更能反映实际负载。
+    忙碌时间相同时(例如都很空闲)取连接数较少的。
+    */
+    EventLoop* Select(const sockaddr_in&) override
+    {
+        EventLoop* selected = reactors_[0];
+        auto smallest = std::make_pair(selected->GetRecentBusyTime(), selected->GetConnectionNum());
+        for (auto reactor : reactors_)
+        {
+            auto load = std::make_pair(reactor->GetRecentBusyTime(), reactor->GetConnectionNum());
+            if(load < smallest)
+            {
+                smallest = load;
+                selected = reactor;
+            }
+        }
+        return selected;
+    }
+};
+
+}
+
+std::optional<BalancePolicy> ParseBalancePolicy(std::string_view name)
+{
+    static const std::pair<std::string_view, BalancePolicy> kPolicies[] = {
+        {"least_conn", BalancePolicy::kLeastConn},
+        {"round_robin", BalancePolicy::kRoundRobin},
+        {"p2c", BalancePolicy::kPowerOfTwo},
+        {"ip_hash", BalancePolicy::kIpHash},
+        {"least_busy", BalancePolicy::kLeastBusy},
+    };
+    for (const auto& [policy_name, policy] : kPolicies)
+    {
+        if(name == policy_name) return policy;
+    }
+    return std::nullopt;
+}
+
+std::unique_ptr<LoadBalancer> LoadBalancer::Create(BalancePolicy policy, std::vector<EventLoop*> reactors)
+{
+    switch (policy) {
+        case BalancePolicy::kRoundRobin:
+            return std::make_unique<RoundRobinBalancer>(std::move(reactors));
+        case BalancePolicy::kPowerOfTwo:
+            return std::make_unique<PowerOfTwoBalancer>(std::move(reactors));
+        case BalancePolicy::kIpHash:
+            return std::make_unique<IpHashBalancer>(std::move(reactors));
+        case BalancePolicy::kLeastBusy:
+            return std::make_unique<LeastBusyBalancer>(std::move(reactors));
+        case BalancePolicy::kLeastConn:
+            break;
+    }
+    return std::make_unique<LeastConnBalancer>(std::move(reactors));
+}
@@ -0,0 +1,156 @@
+#include "OutputQueue.h"
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <errno.h>
+
+void OutputQueue::Append(std::string_view data)
+{
+    if(data.empty()) return;
+    /*与末尾的自有数据合并，首部行逐行追加时只会占用一段*/
+    if(segments_.empty() || segments_.back().type != SegmentType::kOwned)
+    {
+        segments_.push_back({SegmentType::kOwned, std::move(spare_)});
+        segments_.back().owned.clear();
+    }
+    segments_.back().owned.append(data);
+    bytes_ += data.size();
+}
+
+void OutputQueue::Append(std::string&& data)
+{
+    if(data.empty()) return;
+    if(!segments_.empty() && segments_.back().type == SegmentType::kOwned)
+    {
+        Append(std::string_view(data));
+        return;
+    }
+    bytes_ += data.size();
+    segments_.push_back({SegmentType::kOwned, std::move(data)});
+}
+
+char* OutputQueue::AppendUninitialized(size_t n)
+{
+    if(n == 0) return nullptr;
+    if(segments_.empty() || segments_.back().type != SegmentType::kOwned)
+    {
+        segments_.push_back({SegmentType::kOwned, std::move(spare_)});
+        segments_.back().owned.clear();
+    }
+    std::string& owned = segments_.back().owned;
+    size_t old_size = owned.size();
+    owned.resize(old_size + n);
+    bytes_ += n;
+    return owned.data() + old_size;
+}
+
+void OutputQueue::AppendStatic(const char* data, size_t n)
+{
+    if(n == 0) return;
+    segments_.push_back({SegmentType::kStatic, {}, {}, data, n});
+    bytes_ += n;
+}
+
+void OutputQueue::AppendShared(std::shared_ptr<const void> holder, const char* data, size_t n)
+{
+    if(n == 0) return;
+    segments_.push_back({SegmentType::kShared, {}, std::move(holder), data, n});
+    bytes_ += n;
+}
+
+void OutputQueue::AppendFile(std::shared_ptr<const void> holder, int file_fd, off_t offset, size_t n)
+{
+    if(n == 0) return;
+    Segment segment{SegmentType::kFile, {}, std::move(holder)};
+    segment.size = n;
+    segment.file_fd = file_fd;
+    segment.file_offset = offset;
+    segments_.push_back(std::move(segment));
+    bytes_ += n;
+}
+
+void OutputQueue::Clear()
+{
+    while(!segments_.empty()) PopFront();
+    front_offset_ = 0;
+    bytes_ = 0;
+}
+
+ssize_t OutputQueue::WriteFd(int fd, int* saved_errno)
+{
+    auto& front = segments_.front();
+    if(front.type == SegmentType::kFile)
+    {
+        off_t offset = front.file_offset + front_offset_;
+        const ssize_t n = sendfile(fd, front.file_fd, &offset, front.size - front_offset_);
+        if(n < 0) *saved_errno = errno;
+        else if(n == 0)
+        {
+            /*文件在发送过程中被截断了，剩下的数据永远发不出去*/
+            *saved_errno = EIO;
+            return -1;
+        }
+        else Retrieve(n);
+        return n;
+    }
+
+    iovec vec[kMaxIovecNum];
+    msghdr msg{};
+    const ssize_t n = sendmsg(fd, &msg, FillMsg(msg, vec));
+    if(n < 0) *saved_errno = errno;
+    else Retrieve(n);
+    return n;
+}
+
+int OutputQueue::FillMsg(msghdr& msg, iovec* iov) const
+{
+    if(segments_.empty() || segments_.front().type == SegmentType::kFile) return -1;
+    int iovcnt = 0;
+    int flags = MSG_NOSIGNAL;
+    size_t offset = front_offset_;
+    for (auto it = segments_.begin(); it != segments_.end() && iovcnt < kMaxIovecNum; ++it)
+    {
+        if(it->type == SegmentType::kFile)
+        {
+            flags |= MSG_MORE;
+            break;
+        }
+        iov[iovcnt].iov_base = const_cast<char*>(it->Data() + offset);
+        iov[iovcnt].iov_len = it->Size() - offset;
+        ++iovcnt;
+        offset = 0;
+    }
+    msg = msghdr{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    return flags;
+}
+
+void OutputQueue::Retrieve(size_t n)
+{
+    bytes_ -= n;
+    while(n > 0)
+    {
+        size_t remain = segments_.front().Size() - front_offset_;
+        if(n < remain)
+        {
+            front_offset_ += n;
+            return;
+        }
+        n -= remain;
+        PopFront();
+        front_offset_ = 0;
+    }
+}
+
+void OutputQueue::PopFront()
+{
+    /*只保留一个缓冲区，超大的缓冲区(例如POST的响应实体)不保留，避免长连接一直占用内存*/
+    auto& front = segments_.front();
+    static const size_t kMaxSpareCapacity = 16 * 1024;
+    if(front.type == SegmentType::kOwned && front.owned.capacity() > spare_.capacity() &&
+       front.owned.capacity() <= kMaxSpareCapacity)
+    {
+        spare_ = std::move(front.owned);
+    }
+    segments_.pop_front();
+}
@@ -0,0 +1,78 @@
+#include "Poller.h"
+#include "UringPoller.h"
+#include "Utility.h"
+#include <sys/epoll.h>
+
+namespace {
+
+class EpollPoller : public Poller {
+private:
+    static const int kMaxActiveEventNum = 4096;
+    int epollfd_;
+    epoll_event active_events_[kMaxActiveEventNum];               //epoll_wait返回的就绪事件
+public:
+    /*!
+        注意，这里没有使用epoll_create。这是因为，epoll_create函数的size参数只是一个参考
+        实际上，内核epoll事件表是会动态增长的，因此没有必要使用epoll_create了。
+     */
+    EpollPoller() : epollfd_(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~EpollPoller() override {if(epollfd_ >= 0) close(epollfd_);}
+
+    bool Valid() const {return epollfd_ >= 0;}
+
+    bool Add(int fd, uint32_t events) override {return Control(EPOLL_CTL_ADD, fd, events, "add");}
+    bool Mod(int fd, uint32_t events) override {return Control(EPOLL_CTL_MOD, fd, events, "mod");}
+    bool Del(int fd) override                  {return Control(EPOLL_CTL_DEL, fd, 0, "del");}
+
+    int Poll(int timeout_ms, std::vector<ReadyEvent>& active_events) override
+    {
+        active_events.clear();
+        int active_event_num = epoll_wait(epollfd_, active_events_, kMaxActiveEventNum, timeout_ms);
+        for (int i = 0; i < active_event_num; ++i)
+        {
+            active_events.push_back({active_events_[i].data.fd, active_events_[i].events});
+        }
+        return active_event_num;
+    }
+
+    const char* Name() const override {return "epoll";}
+private:
+    bool Control(int op, int fd, uint32_t events, const char* op_name)
+    {
+        epoll_event event{};
+        event.data.fd = fd;
+        event.events = (events | EPOLLET);
+        if(epoll_ctl(epollfd_, op, fd, &event) < 0)
+        {
+            ::GetLogger()->error("epoll {} error: {}", op_name, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+};
+
+}
+
+std::optional<PollerBackend> ParsePollerBackend(std::string_view name)
+{
+    if(name == "epoll") return PollerBackend::kEpoll;
+    if(name == "io_uring") return PollerBackend::kIoUring;
+    return std::nullopt;
+}
+
+std::unique_ptr<Poller> Poller::Create(PollerBackend backend)
+{
+    if(backend == PollerBackend::kIoUring)
+    {
+        auto uring = std::make_unique<UringPoller>();
+        if(uring->Init()) return uring;
+        ::GetLogger()->warn("io_uring is not available, fall back to epoll");
+    }
+    auto epoll = std::make_unique<EpollPoller>();
+    if(!epoll->Valid())
+    {
+        ::GetLogger()->critical("epoll_create1 error: {}", strerror(errno));
+        return nullptr;
+    }
+    return epoll;
+}
@@ -0,0 +1,233 @@
+#include "StaticCache.h"
+#include "Channel.h"
+#include "Utility.h"
+#include "FileCache.h"
+#include <sys/inotify.h>
+#include <algorithm>
+
+/*-----------------------FrequencySketch类-------------------------*/
+namespace {
+
+constexpr std::array<uint64_t, FrequencySketch::kDepth> kSketchSeeds{
+    0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL,
+};
+
+size_t RoundUpPowerOfTwo(size_t n)
+{
+    size_t power = 1;
+    while(power < n) power <<= 1;
+    return power;
+}
+
+}
+
+FrequencySketch::FrequencySketch(size_t width)
+                : table_(kDepth * RoundUpPowerOfTwo(width) / 2),
+                  width_mask_(RoundUpPowerOfTwo(width) - 1),
+                  sample_size_(10 * RoundUpPowerOfTwo(width))
+{
+}
+
+size_t FrequencySketch::IndexOf(size_t hash, size_t row) const
+{
+    uint64_t h = (static_cast<uint64_t>(hash) + row) * kSketchSeeds[row];
+    h ^= h >> 32;
+    return row * (width_mask_ + 1) + (h & width_mask_);
+}
+
+uint8_t FrequencySketch::Counter(size_t index) const
+{
+    return (table_[index / 2] >> ((index & 1) * 4)) & 0x0f;
+}
+
+void FrequencySketch::Increment(size_t hash)
+{
+    bool added = false;
+    for (size_t row = 0; row < kDepth; ++row)
+    {
+        size_t index = IndexOf(hash, row);
+        if(Counter(index) == 0x0f) continue;                  //4位计数器已饱和
+        table_[index / 2] += static_cast<uint8_t>(1u << ((index & 1) * 4));
+        added = true;
+    }
+    if(added && ++additions_ == sample_size_) Reset();
+}
+
+uint8_t FrequencySketch::Estimate(size_t hash) const
+{
+    uint8_t frequency = 0x0f;
+    for (size_t row = 0; row < kDepth; ++row)
+    {
+        frequency = std::min(frequency, Counter(IndexOf(hash, row)));
+    }
+    return frequency;
+}
+
+void FrequencySketch::Reset()
+{
+    /*两个4位计数器同时右移一位，再清掉高位计数器移入低位计数器的那一位*/
+    for (auto& counters : table_) counters = (counters >> 1) & 0x77;
+    additions_ /= 2;
+}
+
+/*-----------------------StaticCache类-------------------------*/
+StaticCache& StaticCache::Instance()
+{
+    static StaticCache cache(GlobalVar::static_cache_budget_);
+    return cache;
+}
+
+StaticCache::StaticCache(size_t budget)
+            : shard_budget_(budget / kShardNum),
+              max_file_size_(budget / kShardNum / 4)
+{
+    if(!Enabled()) return;
+    /*按平均每个文件4KB估计分片能容纳的文件数，计数器的数量与之相当*/
+    size_t sketch_width = std::max<size_t>(shard_budget_ / 4096, 256);
+    for (size_t i = 0; i < kShardNum; ++i)
+    {
+        shards_.emplace_back(std::make_unique<Shard>(sketch_width));
+    }
+}
+
+std::shared_ptr<const CachedFile> StaticCache::Get(std::string_view key)
+{
+    if(!Enabled()) return nullptr;
+    size_t hash = std::hash<std::string_view>{}(key);
+    auto& shard = ShardOf(hash);
+    std::unique_lock locker(shard.mutex);
+    shard.sketch.Increment(hash);
+    auto it = shard.index.find(key);
+    if(it == shard.index.end()) return nullptr;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);   //移到表头
+    return it->second->file;
+}
+
+bool StaticCache::CanAdmit(Shard& shard, size_t charge, uint8_t frequency) const
+{
+    size_t free_space = shard_budget_ - shard.usage;
+    for (auto it = shard.lru.rbegin(); free_space < charge && it != shard.lru.rend(); ++it)
+    {
+        if(shard.sketch.Estimate(std::hash<std::string_view>{}(it->key)) >= frequency) return false;
+        free_space += it->charge;
+    }
+    return free_space >= charge;
+}
+
+bool StaticCache::WouldAdmit(std::string_view key, size_t header_size, size_t body_size)
+{
+    if(!Enabled() || body_size > max_file_size_) return false;
+    size_t hash = std::hash<std::string_view>{}(key);
+    auto& shard = ShardOf(hash);
+    std::unique_lock locker(shard.mutex);
+    return CanAdmit(shard, ChargeOf(key, header_size, body_size), shard.sketch.Estimate(hash));
+}
+
+bool StaticCache::Insert(std::string_view key, std::shared_ptr<const CachedFile> file, uint64_t generation)
+{
+    size_t charge = ChargeOf(key, file->header.size(), file->body.size());
+    if(!Enabled() || file->body.size() > max_file_size_) return false;
+    size_t hash = std::hash<std::string_view>{}(key);
+    auto& shard = ShardOf(hash);
+    std::unique_lock locker(shard.mutex);
+    /*在锁内检查，Invalidate先加1再加锁删除，这样不会把旧的内容插入缓存*/
+    if(generation != Generation()) return false;
+    if(shard.index.count(key)) return false;
+    if(!CanAdmit(shard, charge, shard.sketch.Estimate(hash))) return false;
+
+    /*淘汰表尾的文件直到空间足够*/
+    while(shard.usage + charge > shard_budget_)
+    {
+        auto& victim = shard.lru.back();
+        shard.usage -= victim.charge;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front({std::string(key), std::move(file), charge});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.usage += charge;
+    return true;
+}
+
+void StaticCache::Invalidate(std::string_view key)
+{
+    if(!Enabled()) return;
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    auto& shard = ShardOf(std::hash<std::string_view>{}(key));
+    std::unique_lock locker(shard.mutex);
+    auto it = shard.index.find(key);
+    if(it == shard.index.end()) return;
+    shard.usage -= it->second->charge;
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+}
+
+void StaticCache::Clear()
+{
+    if(!Enabled()) return;
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (auto& shard : shards_)
+    {
+        std::unique_lock locker(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+        shard->usage = 0;
+    }
+}
+
+Channel* StaticCache::WatchDirectory(const std::string& dir)
+{
+    if(p_watch_channel_) return p_watch_channel_;
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(fd < 0)
+    {
+        ::GetLogger()->error("inotify_init1 error: {}", strerror(errno));
+        return nullptr;
+    }
+    uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+    if(inotify_add_watch(fd, dir.c_str(), mask) < 0)
+    {
+        ::GetLogger()->error("inotify watch {} error: {}", dir, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    p_watch_channel_ = new Channel(fd, false);
+    p_watch_channel_->SetEvents(EPOLLIN);
+    p_watch_channel_->SetReadHandler([this](){WatchHandler();});
+    return p_watch_channel_;
+}
+
+void StaticCache::WatchHandler()
+{
+    alignas(inotify_event) char buffer[4096];
+    int fd = p_watch_channel_->GetFd();
+    while(true)
+    {
+        ssize_t len = read(fd, buffer, sizeof buffer);
+        if(len <= 0)
+        {
+            if(len < 0 && errno == EINTR) continue;
+            return;                                          //EAGAIN，事件已读完
+        }
+        for (char* p = buffer; p < buffer + len; )
+        {
+            auto event = reinterpret_cast<inotify_event*>(p);
+            /*事件队列溢出或目录本身发生变化时无法确定哪些文件受影响，直接清空*/
+            /*!
+                FileCache必须先失效：HttpData先获取代数再从FileCache取文件，这样取到的文件一定不早于
+                该代数，不会把旧文件的内容插入缓存。
+             */
+            if(event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                FileCache::Instance().Clear();
+                Clear();
+            }
+            else if(event->len > 0)
+            {
+                FileCache::Instance().Invalidate(event->name);
+                Invalidate(event->name);
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+}
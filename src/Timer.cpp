@@ -1,135 +1,150 @@
 #include "Timer.h"
-#include "Channel.h"
-#include "Utility.h"
+#include <algorithm>
 
-/*---------------------------------Timer类--------------------------------------*/
-Timer::Timer(size_t trigger_cycles, size_t slot_index)
-            : trigger_cycles_(trigger_cycles),
-              slot_index_(slot_index) {}
-
-
-void Timer::CallExpiredHandler()
+/*------------------------------Timer类----------------------------------*/
+Timer::~Timer()
 {
-    if(expired_sHandler_) expired_sHandler_();
-    else ::GetLogger()->warn("expired handler has not been registered yet");
+    /*时间轮先析构时会摘下所有定时器，这里Linked()为false，不会访问已经销毁的时间轮*/
+    if(Linked() && wheel_) wheel_->DelTimer(this);
 }
 
-/*------------------------------TimerManager类----------------------------------*/
-TimeWheel::TimeWheel()
-{
-    slots_.resize(GlobalVar::slot_num_);
-    /*创建一个管道，通过监听tick_fd_[0]可读事件的形式定时让时间轮tick一下*/
-    int res = pipe(tick_fd_);
-    if(res == -1)
-    {
-        ::GetLogger()->critical("create tick pipe error: {}", strerror(errno));
-        exit(-1);
-    }
-    SetNonBlocking(tick_fd_[0]);
-    SetNonBlocking(tick_fd_[1]);
-    p_tickfd_channel_ = new Channel(tick_fd_[0], false);
-    p_tickfd_channel_->SetEvents(EPOLLIN);
-    p_tickfd_channel_->SetReadHandler([this](){Tick();});
-}
+/*------------------------------TimeWheel类----------------------------------*/
+TimeWheel::TimeWheel(std::chrono::milliseconds tick_interval, size_t expire_budget, std::chrono::milliseconds jitter)
+                    : tick_interval_(std::max(tick_interval, std::chrono::milliseconds(1))),
+                      expire_budget_(expire_budget),
+                      jitter_ticks_(std::max<int64_t>(jitter.count(), 0) / tick_interval_.count()) {}
 
 TimeWheel::~TimeWheel()
 {
-    /*delete所有timer*/
-    for (auto& slot : slots_)
+    /*定时器由使用者管理，这里只把它们摘下，之后定时器析构时不会再访问已经销毁的槽*/
+    for (auto& level : slots_)
     {
-        for (auto& timer : slot)
+        for (auto& slot : level)
         {
-            delete timer;
+            while(slot.Linked()) slot.next->Unlink();
         }
     }
-    /*关闭管道*/
-    close(tick_fd_[0]);
-    close(tick_fd_[1]);
+    while(overdue_.Linked()) overdue_.next->Unlink();
 }
 
-Timer* TimeWheel::AddTimer(std::chrono::seconds timeout)
+void TimeWheel::AddTimer(Timer* timer, std::chrono::milliseconds timeout)
 {
-     /*创建一个Timer并加入到时间轮的对应槽之中*/
-     auto pos = CalPosInWheel(timeout);
-     if(!pos) return nullptr;
-     Timer* p_timer = new Timer(pos->first,pos->second);
-     slots_[pos->second].push_back(p_timer);
+    if(!timer) return;
+    if(timer->Linked()) timer->Unlink();
+    else ++timer_num_;
+    timer->wheel_ = this;
+    timer->expire_tick_ = std::min(ExpireTickOf(timeout) + RandomJitter(), current_tick_ + kMaxTicks);
+    timer->scheduled_tick_ = timer->expire_tick_;
+    Schedule(timer);
+}
 
-     return p_timer;
+void TimeWheel::RefreshTimer(Timer* timer, std::chrono::milliseconds timeout)
+{
+    if(!timer) return;
+    uint64_t expire_tick = ExpireTickOf(timeout);
+    /*提前到期(超出抖动范围)时必须移动定时器，否则它会在原来的槽中晚触发*/
+    if(!timer->Linked() || expire_tick + jitter_ticks_ < timer->expire_tick_)
+    {
+        AddTimer(timer, timeout);
+        return;
+    }
+    timer->expire_tick_ = std::max(timer->expire_tick_, expire_tick);
 }
 
 void TimeWheel::DelTimer(Timer* timer)
 {
-    if(!timer) return;
-    /*从时间轮中删除目标Timer并delete*/
-    size_t index = timer->GetSlotIndex();
-    slots_[index].remove(timer);
-    delete timer;
+    if(!timer || !timer->Linked()) return;
+    timer->Unlink();
+    --timer_num_;
 }
 
-void TimeWheel::AdjustTimer(Timer* timer, std::chrono::seconds timeout)
+void TimeWheel::Advance()
 {
-    auto pos = CalPosInWheel(timeout);
-    if(!timer || !pos) return;
+    ++current_tick_;
+    size_t index = current_tick_ & (kSlotNum - 1);
+    /*第0层转完一圈，先把上层到期的定时器放下来，它们可能就落在当前槽中*/
+    if(index == 0) Cascade(1);
 
-    /*先从时间轮中移除timer，但不要delete*/
-    size_t index = timer->GetSlotIndex();
-    slots_[index].remove(timer);
-    /*修改timer的触发圈数以及所在的槽，并加入到时间轮中相应的槽*/
-    timer->SetTriggerCycles(pos->first);
-    timer->SetSlotIndex(pos->second);
-    slots_[pos->second].push_back(timer);
+    /*把当前槽整个接到overdue_的末尾，先到期的先触发*/
+    TimerNode& slot = slots_[0][index];
+    if(!slot.Linked()) return;
+    TimerNode* first = slot.next;
+    TimerNode* last = slot.prev;
+    first->prev = overdue_.prev;
+    overdue_.prev->next = first;
+    last->next = &overdue_;
+    overdue_.prev = last;
+    slot.prev = slot.next = &slot;
 }
 
-void TimeWheel::Tick()
+size_t TimeWheel::ExpireOverdue()
 {
-    /*从管道读出数据以防写满*/
-    char msg[128];
-    ReadData(tick_fd_[0],msg,128);
-
-    /*值得注意的是，这里是在遍历容器的时候删除特定元素。*/
-    for (auto it = slots_[current_slot_].begin();it != slots_[current_slot_].end();)
+    /*!
+        每次从overdue_头部取一个。回调函数可能删除overdue_中的其它定时器，也可能把定时器重新加入
+        时间轮，都不会影响这里的遍历。
+     */
+    size_t fired = 0;
+    while(overdue_.Linked() && (expire_budget_ == 0 || fired < expire_budget_))
     {
-        /*删除空指针以防万一*/
-        Timer* p_timer = *it;
-        if(!p_timer)
+        auto timer = static_cast<Timer*>(overdue_.next);
+        timer->Unlink();
+        /*到期时间在放入槽之后被RefreshTimer延后了，按新的到期tick重新放入*/
+        if(timer->expire_tick_ > current_tick_)
         {
-            it = slots_[current_slot_].erase(it);
+            timer->scheduled_tick_ = timer->expire_tick_;
+            Schedule(timer);
             continue;
         }
-        
-        /*trigger_cycles_大于0说明还未到触发时间*/
-        if(p_timer->GetTriggerCycles() > 0)
-        {
-            p_timer->ReduceTriggerCyclesByOne();             //减一，表示经过了这个槽。
-            ++it;
-        }
-        /*小于0则说明到触发时间了*/
-        else
-        {
-            auto next = ++it;
-            p_timer->CallExpiredHandler();                  //关闭连接 删除时间 删除定时器
-            it = next;
-        }
+        --timer_num_;
+        ++fired;
+        timer->CallExpiredHandler();              //关闭连接 删除事件
     }
-    current_slot_ = ++current_slot_ % GlobalVar::slot_num_;  //指向下一个槽
+    return fired;
 }
 
-std::optional<std::pair<size_t /*cycle*/, size_t /*index*/>> TimeWheel::CalPosInWheel(std::chrono::seconds timeout)
+uint64_t TimeWheel::ExpireTickOf(std::chrono::milliseconds timeout) const
 {
-    if(timeout<std::chrono::seconds(0))
-    {
-        ::GetLogger()->warn("timeout can't be less than 0");
-        return std::nullopt;
-    }
     /*!
-        根据超时值计算该计时器将在时间轮转动多少次（即多少个tick）之后被触发。如果timeout小于slot_interval_，tick折合为１
-        否则向下折合为timeout/slot_interval_。然后，计算计时器的触发圈数以及应放入哪一个槽中。
+        根据超时值计算该计时器将在时间轮转动多少次（即多少个tick）之后被触发。当前tick已经过去了一部分，
+        因此向上折合后再加一，保证定时器不会提前触发。
      */
-    size_t ticks = 0;
-    if(timeout < GlobalVar::slot_interval_) ticks = 1;
-    else ticks = timeout / GlobalVar::slot_interval_;
-    size_t cycle = ticks / GlobalVar::slot_num_;                                           //timer将在时间轮转动cycle圈后被触发
-    size_t index = (current_slot_ + (ticks % GlobalVar::slot_num_)) % GlobalVar::slot_num_; //timer被放置的槽的序号
-    return std::make_pair(cycle,index);
-}
\ No newline at end of file
+    auto timeout_ms = static_cast<uint64_t>(std::max(timeout.count(), std::chrono::milliseconds::rep(0)));
+    uint64_t ticks = std::min<uint64_t>((timeout_ms + tick_interval_.count() - 1) / tick_interval_.count() + 1, kMaxTicks);
+    return current_tick_ + ticks;
+}
+
+uint64_t TimeWheel::RandomJitter()
+{
+    if(jitter_ticks_ == 0) return 0;
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 7;
+    random_state_ ^= random_state_ << 17;
+    return random_state_ % (jitter_ticks_ + 1);
+}
+
+void TimeWheel::Schedule(Timer* timer)
+{
+    /*放置tick与当前tick的差值决定所在的层，槽由放置tick在该层对应的位决定*/
+    uint64_t expire = std::max(timer->scheduled_tick_, current_tick_);
+    uint64_t delta = expire - current_tick_;
+    size_t level = 0;
+    while(level + 1 < kLevelNum && delta >= (uint64_t(1) << (kLevelBits * (level + 1)))) ++level;
+    size_t index = (expire >> (kLevelBits * level)) & (kSlotNum - 1);
+    timer->InsertBefore(&slots_[level][index]);
+}
+
+void TimeWheel::Cascade(size_t level)
+{
+    if(level >= kLevelNum) return;
+    size_t index = (current_tick_ >> (kLevelBits * level)) & (kSlotNum - 1);
+    if(index == 0) Cascade(level + 1);
+
+    TimerNode& slot = slots_[level][index];
+    while(slot.Linked())
+    {
+        auto timer = static_cast<Timer*>(slot.next);
+        timer->Unlink();
+        timer->scheduled_tick_ = timer->expire_tick_;       //顺便按延后的到期tick放置
+        Schedule(timer);
+    }
+}
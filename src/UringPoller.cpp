@@ -0,0 +1,546 @@
+#include "UringPoller.h"
+#include "Utility.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace {
+
+int IoUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg, size_t arg_size)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, const void* arg, unsigned nr_args)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+int64_t ToNanoseconds(const __kernel_timespec& ts)
+{
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t MonotonicNow()
+{
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+}
+
+UringPoller::~UringPoller()
+{
+    if(sqes_) munmap(sqes_, sqes_size_);
+    if(ring_) munmap(ring_, ring_size_);
+    if(ring_fd_ >= 0) close(ring_fd_);
+    if(buf_ring_) munmap(buf_ring_, kBufferNum * sizeof(io_uring_buf));
+    if(buffers_) munmap(buffers_, size_t(kBufferNum) * kBufferSize);
+}
+
+bool UringPoller::Init()
+{
+    /*COOP_TASKRUN：完成项在下一次io_uring_enter时处理，不必用IPI打断正在执行回调函数的线程*/
+    io_uring_params params{};
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    ring_fd_ = IoUringSetup(kEntries, &params);
+    if(ring_fd_ < 0 && errno == EINVAL)
+    {
+        params = io_uring_params{};
+        ring_fd_ = IoUringSetup(kEntries, &params);
+    }
+    if(ring_fd_ < 0)
+    {
+        ::GetLogger()->warn("io_uring_setup error: {}", strerror(errno));
+        return false;
+    }
+    const unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if((params.features & required) != required)
+    {
+        ::GetLogger()->warn("io_uring features {:#x} are not enough", params.features);
+        return false;
+    }
+
+    /*提交队列和完成队列映射到同一块内存，取两者中较大的长度*/
+    ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void* ring = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if(ring == MAP_FAILED)
+    {
+        ::GetLogger()->warn("io_uring mmap error: {}", strerror(errno));
+        return false;
+    }
+    ring_ = ring;
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED)
+    {
+        ::GetLogger()->warn("io_uring mmap error: {}", strerror(errno));
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto base = static_cast<char*>(ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_ = *sq_tail_;
+    cq_head_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    cq_mask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+
+    /*!
+        features中没有表示multishot poll的标志，用一个已经可读的eventfd试一次。不支持的内核会以
+        -EINVAL完成这一项，ReapCompletions将其转换为EPOLLERR。
+     */
+    int probe_fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(probe_fd < 0) return false;
+    std::vector<ReadyEvent> events;
+    bool supported = Add(probe_fd, EPOLLIN) && Poll(1000, events) > 0 && !(events.front().events & EPOLLERR);
+    Del(probe_fd);
+    close(probe_fd);
+    if(!supported)
+    {
+        ::GetLogger()->warn("io_uring multishot poll is not supported");
+        return false;
+    }
+
+    /*缓冲区环或multishot recv不可用时仍然可以只用multishot poll*/
+    async_io_ = InitBufferRing();
+    if(!async_io_) ::GetLogger()->warn("io_uring provided buffers or multishot recv are not supported, use poll only");
+    return true;
+}
+
+bool UringPoller::InitBufferRing()
+{
+    /*缓冲区环本身必须按页对齐；缓冲区只是保留地址空间，用到时才分配物理内存*/
+    void* ring = mmap(nullptr, kBufferNum * sizeof(io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* buffers = mmap(nullptr, size_t(kBufferNum) * kBufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ring != MAP_FAILED) buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+    if(buffers != MAP_FAILED) buffers_ = static_cast<char*>(buffers);
+    if(!buf_ring_ || !buffers_) return false;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = kBufferNum;
+    reg.bgid = kBufferGroup;
+    if(IoUringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        ::GetLogger()->warn("io_uring register buffer ring error: {}", strerror(errno));
+        return false;
+    }
+    for (unsigned bid = 0; bid < kBufferNum; ++bid) used_buffers_.push_back(static_cast<uint16_t>(bid));
+    ReturnBuffers();
+
+    /*multishot recv(6.0)同样没有对应的features标志，用socketpair试一次*/
+    int fds[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) return false;
+    /*前面的poll探测留下的取消完成项可能先到，最多等几轮*/
+    std::vector<ReadyEvent> events;
+    bool supported = write(fds[1], "x", 1) == 1 && AddConnection(fds[0]);
+    for (int i = 0; supported && i < 4 && events.empty(); ++i)
+    {
+        if(Poll(1000, events) < 0) supported = false;
+    }
+    supported = supported && !events.empty() && events.front().type == EventType::kRecv && events.front().result == 1;
+    Del(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+    return supported;
+}
+
+bool UringPoller::Add(int fd, uint32_t events)
+{
+    auto& registration = registrations_[fd];
+    if(registration.active) Del(fd);
+    ++registration.generation;
+    ++registration.poll_generation;
+    registration.events = events;
+    registration.active = true;
+    return ArmPoll(fd, registration);
+}
+
+bool UringPoller::AddConnection(int fd)
+{
+    auto& registration = registrations_[fd];
+    if(registration.active) Del(fd);
+    ++registration.generation;
+    ++registration.poll_generation;
+    registration.active = true;
+    registration.connection = true;
+    registration.recv_paused = false;
+    return ArmRecv(fd, registration);
+}
+
+bool UringPoller::AddAcceptor(int listenfd)
+{
+    if(!async_io_) return false;
+    auto& registration = registrations_[listenfd];
+    if(registration.active) Del(listenfd);
+    ++registration.generation;
+    ++registration.poll_generation;
+    registration.active = true;
+    registration.acceptor = true;
+    return ArmAccept(listenfd, registration);
+}
+
+bool UringPoller::Mod(int fd, uint32_t events)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->active)
+    {
+        ::GetLogger()->error("io_uring mod error: fd {} is not registered", fd);
+        return false;
+    }
+    /*连接socket的读事件和错误由recv报告，poll只用来等待EPOLLOUT*/
+    if(registration->connection) events &= EPOLLOUT;
+    if(registration->events == events) return true;
+    /*取消旧的poll并以新的代数重新注册，两项在下一次Poll时一起提交*/
+    if(registration->events) Cancel(MakeUserData(Op::kPoll, fd, registration->poll_generation));
+    ++registration->poll_generation;
+    registration->events = events;
+    return events == 0 || ArmPoll(fd, *registration);
+}
+
+bool UringPoller::Del(int fd)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->active)
+    {
+        ::GetLogger()->error("io_uring del error: fd {} is not registered", fd);
+        return false;
+    }
+    /*!
+        请求持有文件的引用，fd关闭后要等到取消请求提交才会真正释放socket。按user_data而不是按fd取消，
+        取消请求提交时fd可能已经被关闭并分给了新的连接。
+     */
+    if(registration->events) Cancel(MakeUserData(Op::kPoll, fd, registration->poll_generation));
+    if(registration->recv_armed) Cancel(MakeUserData(Op::kRecv, fd, registration->generation));
+    if(registration->acceptor) Cancel(MakeUserData(Op::kAccept, fd, registration->generation));
+    ++registration->generation;
+    ++registration->poll_generation;
+    registration->events = 0;
+    registration->active = false;
+    registration->connection = false;
+    registration->acceptor = false;
+    registration->recv_armed = false;
+    registration->recv_paused = false;
+    /*!
+        调用者接着就会关闭fd。提交队列中还可能有以fd为目标的请求(例如刚重新注册的recv)，如果等到下一次
+        Poll才提交，fd可能已经分给了新的连接，这些请求会作用在新连接上。这里立刻提交，顺便让取消尽早生效。
+     */
+    if(PendingSqes() > 0 && IoUringEnter(ring_fd_, PendingSqes(), 0, 0, nullptr, 0) < 0)
+    {
+        ::GetLogger()->error("io_uring submit error: {}", strerror(errno));
+    }
+    return true;
+}
+
+void UringPoller::PauseRecv(int fd)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->connection || registration->recv_paused) return;
+    registration->recv_paused = true;
+    /*recv的最后一项(-ECANCELED)到达时才清除recv_armed*/
+    if(registration->recv_armed) Cancel(MakeUserData(Op::kRecv, fd, registration->generation));
+}
+
+void UringPoller::ResumeRecv(int fd)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->connection || !registration->recv_paused) return;
+    registration->recv_paused = false;
+    /*取消还未完成时不重复注册，最后一项到达时会重新注册*/
+    if(!registration->recv_armed) ArmRecv(fd, *registration);
+}
+
+bool UringPoller::Send(int fd, const msghdr* msg, int flags)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->connection) return false;
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_SENDMSG;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(msg);
+    sqe.len = 1;
+    sqe.msg_flags = static_cast<uint32_t>(flags);
+    sqe.user_data = MakeUserData(Op::kSend, fd, registration->generation);
+    return PushSqe(sqe);
+}
+
+bool UringPoller::StartTicker(std::chrono::milliseconds interval)
+{
+    if(!async_io_ || interval.count() <= 0) return false;
+    tick_interval_ = interval;
+    int64_t deadline = MonotonicNow() + tick_interval_.count();
+    tick_deadline_.tv_sec = deadline / 1000000000;
+    tick_deadline_.tv_nsec = deadline % 1000000000;
+    return ArmTick();
+}
+
+bool UringPoller::IsStale(const ReadyEvent& event) const
+{
+    if(event.type == EventType::kTick) return false;
+    auto registration = registrations_.Find(event.fd);
+    return !registration || !registration->active || registration->generation != event.generation;
+}
+
+int UringPoller::Poll(int timeout_ms, std::vector<ReadyEvent>& active_events)
+{
+    active_events.clear();
+    /*上一批事件的回调函数都已返回，它们引用的缓冲区可以还给内核了*/
+    ReturnBuffers();
+    /*完成队列中已有未取出的项时只提交不等待*/
+    bool has_completions = *cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    __kernel_timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000LL};
+    io_uring_getevents_arg arg{};
+    arg.ts = reinterpret_cast<uint64_t>(&timeout);
+    unsigned min_complete = has_completions ? 0 : 1;
+    unsigned flags = IORING_ENTER_EXT_ARG | (has_completions ? 0 : IORING_ENTER_GETEVENTS);
+    if(IoUringEnter(ring_fd_, PendingSqes(), min_complete, flags, &arg, sizeof arg) < 0)
+    {
+        /*ETIME表示超时；EBUSY表示完成队列溢出，取出完成项后即可恢复*/
+        if(errno != ETIME && errno != EBUSY) return -1;
+    }
+    ReapCompletions(active_events);
+    return static_cast<int>(active_events.size());
+}
+
+bool UringPoller::PushSqe(const io_uring_sqe& sqe)
+{
+    if(PendingSqes() == sq_entries_)
+    {
+        /*提交队列已满，先把已有的项交给内核*/
+        if(IoUringEnter(ring_fd_, sq_entries_, 0, 0, nullptr, 0) < 0 && PendingSqes() == sq_entries_)
+        {
+            ::GetLogger()->error("io_uring submit error: {}", strerror(errno));
+            return false;
+        }
+    }
+    unsigned index = sqe_tail_ & sq_mask_;
+    sqes_[index] = sqe;
+    sq_array_[index] = index;
+    ++sqe_tail_;
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);     //写完之后再发布给内核
+    return true;
+}
+
+bool UringPoller::ArmPoll(int fd, const Registration& registration)
+{
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    sqe.poll32_events = registration.events;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.user_data = MakeUserData(Op::kPoll, fd, registration.poll_generation);
+    return PushSqe(sqe);
+}
+
+bool UringPoller::ArmRecv(int fd, Registration& registration)
+{
+    /*不指定缓冲区，由内核从缓冲区组kBufferGroup中取一个，完成项的flags中带有缓冲区的编号*/
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = fd;
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = kBufferGroup;
+    sqe.user_data = MakeUserData(Op::kRecv, fd, registration.generation);
+    registration.recv_armed = PushSqe(sqe);
+    return registration.recv_armed;
+}
+
+bool UringPoller::ArmAccept(int fd, const Registration& registration)
+{
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_ACCEPT;
+    sqe.fd = fd;
+    sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe.accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe.user_data = MakeUserData(Op::kAccept, fd, registration.generation);
+    return PushSqe(sqe);
+}
+
+bool UringPoller::ArmTick()
+{
+    /*count为0表示纯定时，内核在提交时就复制了tick_deadline_*/
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_TIMEOUT;
+    sqe.fd = -1;
+    sqe.addr = reinterpret_cast<uint64_t>(&tick_deadline_);
+    sqe.len = 1;
+    sqe.timeout_flags = IORING_TIMEOUT_ABS;
+    sqe.user_data = MakeUserData(Op::kTick, 0, 0);
+    return PushSqe(sqe);
+}
+
+bool UringPoller::Cancel(uint64_t user_data)
+{
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.fd = -1;
+    sqe.addr = user_data;
+    sqe.user_data = MakeUserData(Op::kIgnored, 0, 0);
+    return PushSqe(sqe);
+}
+
+void UringPoller::RecycleBuffer(uint16_t bid)
+{
+    /*!
+        不能用buf_ring_->bufs：旧版头文件的__DECLARE_FLEX_ARRAY在C++中会在bufs前面放一个大小为1的空结构体，
+        bufs被推后8个字节，与内核的布局不一致。缓冲区环就是io_uring_buf数组，tail与第0项的resv重叠。
+     */
+    io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(buf_ring_)[buf_tail_ & (kBufferNum - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffers_ + size_t(bid) * kBufferSize);
+    buf.len = kBufferSize;
+    buf.bid = bid;
+    ++buf_tail_;
+}
+
+void UringPoller::ReturnBuffers()
+{
+    if(used_buffers_.empty()) return;
+    for (auto bid : used_buffers_) RecycleBuffer(bid);
+    used_buffers_.clear();
+    __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);    //写完之后再发布给内核
+}
+
+unsigned UringPoller::PendingSqes() const
+{
+    return sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+}
+
+void UringPoller::ReapCompletions(std::vector<ReadyEvent>& active_events)
+{
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        /*无论事件是否过期，内核选出的缓冲区都要归还*/
+        if(cqe.flags & IORING_CQE_F_BUFFER) used_buffers_.push_back(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        auto op = static_cast<Op>(cqe.user_data >> 56);
+        int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+        auto generation = static_cast<uint32_t>(cqe.user_data >> 32) & 0xFFFFFF;
+        switch (op) {
+            case Op::kPoll:
+                HandlePollCompletion(cqe, fd, generation, active_events);
+                break;
+            case Op::kRecv:
+                HandleRecvCompletion(cqe, fd, generation, active_events);
+                break;
+            case Op::kAccept:
+                HandleAcceptCompletion(cqe, fd, generation, active_events);
+                break;
+            case Op::kSend:{
+                auto registration = registrations_.Find(fd);
+                if(registration && registration->active && (registration->generation & 0xFFFFFF) == generation)
+                    active_events.push_back({fd, 0, EventType::kSend, cqe.res, nullptr, registration->generation});
+            }break;
+            case Op::kTick:
+                HandleTickCompletion(cqe, active_events);
+                break;
+            case Op::kIgnored:
+                break;
+        }
+    }
+    __atomic_store_n(cq_head_, tail, __ATOMIC_RELEASE);
+}
+
+void UringPoller::HandlePollCompletion(const io_uring_cqe& cqe, int fd, uint32_t generation, std::vector<ReadyEvent>& active_events)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->active || (registration->poll_generation & 0xFFFFFF) != generation) return;  //已注销或已修改
+
+    if(cqe.res < 0 && cqe.res != -ECANCELED)
+    {
+        ::GetLogger()->error("io_uring poll error on fd {}: {}", fd, strerror(-cqe.res));
+        active_events.push_back({fd, EPOLLERR, EventType::kReady, 0, nullptr, registration->generation});
+        return;
+    }
+    if(cqe.res > 0) active_events.push_back({fd, static_cast<uint32_t>(cqe.res), EventType::kReady, 0, nullptr, registration->generation});
+    /*multishot被内核终止(例如完成队列溢出)时重新注册*/
+    if(!(cqe.flags & IORING_CQE_F_MORE)) ArmPoll(fd, *registration);
+}
+
+void UringPoller::HandleRecvCompletion(const io_uring_cqe& cqe, int fd, uint32_t generation, std::vector<ReadyEvent>& active_events)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->active || (registration->generation & 0xFFFFFF) != generation) return;
+
+    if(cqe.res > 0)
+    {
+        const char* data = buffers_ + size_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT) * kBufferSize;
+        active_events.push_back({fd, 0, EventType::kRecv, cqe.res, data, registration->generation});
+    }
+    else if(cqe.res != -ENOBUFS && cqe.res != -ECANCELED)
+    {
+        /*0表示对端关闭了连接，负数表示出错，都交给回调函数处理，不再重新注册*/
+        active_events.push_back({fd, 0, EventType::kRecv, cqe.res, nullptr, registration->generation});
+        registration->recv_armed = false;
+        return;
+    }
+    if(cqe.flags & IORING_CQE_F_MORE) return;
+    /*!
+        multishot recv结束了：缓冲区用完(-ENOBUFS)、被PauseRecv取消或者被内核终止。缓冲区在下一次
+        Poll提交之前归还，这里直接重新注册；暂停时等ResumeRecv再注册。
+     */
+    registration->recv_armed = false;
+    if(!registration->recv_paused) ArmRecv(fd, *registration);
+}
+
+void UringPoller::HandleAcceptCompletion(const io_uring_cqe& cqe, int fd, uint32_t generation, std::vector<ReadyEvent>& active_events)
+{
+    auto registration = registrations_.Find(fd);
+    if(!registration || !registration->active || (registration->generation & 0xFFFFFF) != generation)
+    {
+        /*监听socket已注销，新连接没有人处理*/
+        if(cqe.res >= 0) close(cqe.res);
+        return;
+    }
+    if(cqe.res != -ECANCELED) active_events.push_back({fd, 0, EventType::kAccept, cqe.res, nullptr, registration->generation});
+    if(cqe.flags & IORING_CQE_F_MORE) return;
+    /*!
+        fd或内存耗尽时立刻重新注册只会马上再次失败，等到下一个tick再注册，与epoll下等待下一个新连接
+        的效果相当。
+     */
+    if(cqe.res == -EMFILE || cqe.res == -ENFILE || cqe.res == -ENOBUFS || cqe.res == -ENOMEM)
+    {
+        deferred_acceptors_.push_back(fd);
+        return;
+    }
+    ArmAccept(fd, *registration);
+}
+
+void UringPoller::HandleTickCompletion(const io_uring_cqe& cqe, std::vector<ReadyEvent>& active_events)
+{
+    if(cqe.res != -ETIME) return;
+    /*事件循环被阻塞超过一个间隔时把错过的tick合并成一个事件，与timerfd的到期次数相同*/
+    int64_t interval = tick_interval_.count();
+    int64_t deadline = ToNanoseconds(tick_deadline_);
+    int64_t now = MonotonicNow();
+    int64_t expirations = 1;
+    if(now > deadline) expirations += (now - deadline) / interval;
+    deadline += expirations * interval;
+    tick_deadline_.tv_sec = deadline / 1000000000;
+    tick_deadline_.tv_nsec = deadline % 1000000000;
+    ArmTick();
+    active_events.push_back({-1, 0, EventType::kTick, static_cast<int>(expirations)});
+
+    for (int fd : deferred_acceptors_)
+    {
+        auto registration = registrations_.Find(fd);
+        if(registration && registration->active && registration->acceptor) ArmAccept(fd, *registration);
+    }
+    deferred_acceptors_.clear();
+}
@@ -1,4 +1,6 @@
 #include "Utility.h"
+#include "Buffer.h"
+#include "OutputQueue.h"
 #include <getopt.h>
 #include <stdlib.h>
 #include <regex>
@@ -6,14 +8,25 @@
 ///////////////////////////
 //   Global    Variables //
 ///////////////////////////
-std::mutex GlobalVar::mutex_{};
-int GlobalVar::total_user_num_ = 0;
-std::chrono::seconds GlobalVar::slot_interval_ = std::chrono::seconds(1);            /* NOLINT */
+ShardedCounter GlobalVar::total_user_num_{};
+std::chrono::milliseconds GlobalVar::slot_interval_ = std::chrono::milliseconds(10);  /* NOLINT */
 std::chrono::seconds GlobalVar::client_header_timeout_ = std::chrono::seconds(60);   /* NOLINT */
 std::chrono::seconds GlobalVar::client_body_timeout_ = std::chrono::seconds(60);     /* NOLINT */
 std::chrono::seconds GlobalVar::keep_alive_timeout_ = std::chrono::seconds(60);      /* NOLINT */
-int GlobalVar::slot_num_ = 60;
-const int kMaxBufferSize = 4096;
+size_t GlobalVar::timer_expire_budget_ = 256;
+std::chrono::milliseconds GlobalVar::timeout_jitter_ = std::chrono::milliseconds(0);  /* NOLINT */
+size_t GlobalVar::static_cache_budget_ = 64 * 1024 * 1024;
+size_t GlobalVar::compress_cache_budget_ = 16 * 1024 * 1024;
+size_t GlobalVar::open_file_cache_max_ = 1024;
+std::chrono::seconds GlobalVar::open_file_cache_valid_ = std::chrono::seconds(5);     /* NOLINT */
+std::chrono::seconds GlobalVar::open_file_cache_inactive_ = std::chrono::seconds(20); /* NOLINT */
+bool GlobalVar::reuse_port_ = false;
+BalancePolicy GlobalVar::balance_policy_ = BalancePolicy::kLeastConn;
+PollerBackend GlobalVar::poller_backend_ = PollerBackend::kEpoll;
+size_t GlobalVar::object_pool_warm_ = 64;
+size_t GlobalVar::object_pool_low_ = 256;
+size_t GlobalVar::object_pool_high_ = 1024;
+std::string GlobalVar::resource_dir_ = "../resource/";                                /* NOLINT */
 char GlobalVar::favicon[555] = {
         '\x89', 'P',    'N',    'G',    '\xD',  '\xA',  '\x1A', '\xA',  '\x0',
         '\x0',  '\x0',  '\xD',  'I',    'H',    'D',    'R',    '\x0',  '\x0',
@@ -96,7 +109,7 @@ void SetSocketNoDelay(int fd)
     setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void*)&enable, sizeof(enable));
 }
 
-int BindAndListen(int port)
+int BindAndListen(int port, bool reuse_port)
 {
     if(port<0 || port > 65535) return -1;
     int listenfd = socket(PF_INET,SOCK_STREAM,0);
@@ -116,6 +129,12 @@ int BindAndListen(int port)
         close(listenfd);
         return -1;
     }
+    if(reuse_port && setsockopt(listenfd,SOL_SOCKET,SO_REUSEPORT,&reuse,sizeof reuse) == -1)
+    {
+        ::GetLogger()->error("set SO_REUSEPORT error: {}", strerror(errno));
+        close(listenfd);
+        return -1;
+    }
 
     /*绑定地址*/
     sockaddr_in server_addr{};
@@ -135,6 +154,9 @@ int BindAndListen(int port)
         return -1;
     }
 
+    /*连接socket会继承监听socket的TCP_NODELAY，accept之后不需要再逐个设置*/
+    SetSocketNoDelay(listenfd);
+
     /*!
       从内核2.2版本之后，listen函数的backlog参数表示的是全连接的数量上限。
       所谓全连接，指的是完成了tcp三次握手处于establish状态的连接。也就是
@@ -155,17 +177,27 @@ int BindAndListen(int port)
     return listenfd;
 }
 
-std::string GetTime()
+std::string FormatHttpTime(time_t t)
 {
-    time_t raw_time;
-    struct tm* time_info;
+    struct tm time_info{};
     char time_buffer[30]{};
-    time(&raw_time);
-    time_info = gmtime(&raw_time);
-    strftime(time_buffer, sizeof(time_buffer), "%a, %d %b %Y %H:%M:%S GMT", time_info);
+    gmtime_r(&t, &time_info);          //gmtime返回的是静态对象，多个SubReactor同时调用时不安全
+    strftime(time_buffer, sizeof(time_buffer), "%a, %d %b %Y %H:%M:%S GMT", &time_info);
     return std::string(time_buffer);
 }
 
+std::optional<time_t> ParseHttpTime(std::string_view text)
+{
+    if(text.empty() || text.size() >= 64) return std::nullopt;
+    char buffer[64];
+    memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+    struct tm time_info{};
+    const char* end = strptime(buffer, "%a, %d %b %Y %H:%M:%S GMT", &time_info);
+    if(!end || *end != '\0') return std::nullopt;
+    return timegm(&time_info);
+}
+
 ssize_t ReadData(int fd, char* dest, size_t n)
 {
     char* pos = dest;       //本次存放读取的数据的首地址
@@ -195,15 +227,33 @@ ssize_t ReadData(int fd, char* dest, size_t n)
     return read_sum;
 }
 
-ssize_t ReadData(int fd,std::string& buffer,bool& disconnect)
+ssize_t ReadData(int fd, char* dest, size_t n, off_t offset)
+{
+    size_t read_sum = 0;    //一共读取的字节数
+    while(read_sum < n)
+    {
+        ssize_t read_once = pread(fd, dest + read_sum, n - read_sum, offset + read_sum);
+        if(read_once < 0)
+        {
+            if(errno == EINTR) continue;               //被系统中断就再重新读一次
+            ::GetLogger()->error("pread data from filefd {} error: {}", fd, strerror(errno));
+            return -1;
+        }
+        else if(read_once == 0) break;                 //已到文件末尾
+        read_sum += read_once;
+    }
+
+    return static_cast<ssize_t>(read_sum);
+}
+
+ssize_t ReadData(int fd, Buffer& buffer, bool& disconnect)
 {
     ssize_t read_once = 0;   //本次读取的字节数
     ssize_t read_sum = 0;    //读取的总字节数
     while(true)
     {
-        char temp[kMaxBufferSize];
-        memset(temp,'\0',4096);
-        read_once = recv(fd,temp,kMaxBufferSize,0);
+        int saved_errno = 0;
+        read_once = buffer.ReadFd(fd, &saved_errno);   //数据直接读入buffer，不够时才用到栈上的额外空间
         if(read_once < 0)
         {
             /*!
@@ -213,27 +263,26 @@ ssize_t ReadData(int fd,std::string& buffer,bool& disconnect)
                采取的策略为重新再读一次，因为我们无法判断缓冲区中是否有数据可读。然而，对于
                EAGAIN或EWOULDBLOCK的情况，就直接返回，因为操作系统明确告知了我们当前无数据
                可读。
-             2.若当前有数据可读，那么recv函数并不会立即返回，而是开始从内核中将数据拷贝到用
+             2.若当前有数据可读，那么readv函数并不会立即返回，而是开始从内核中将数据拷贝到用
                户区，这是一个同步操作，返回值为这一次函数调用成功拷贝的字节数。所以说，非阻
                塞I/O本质上还是同步的，并不是异步的。
              */
-            if(errno == EINTR) continue;                                      //被系统中断就再重新读一次
-            else if(errno == EAGAIN || errno == EWOULDBLOCK) return read_sum; //当前无数据可读
+            if(saved_errno == EINTR) continue;                                      //被系统中断就再重新读一次
+            else if(saved_errno == EAGAIN || saved_errno == EWOULDBLOCK) return read_sum; //当前无数据可读
             else
             {
-                ::GetLogger()->error("read data from socket {} error: {}", fd, strerror(errno));
+                ::GetLogger()->error("read data from socket {} error: {}", fd, strerror(saved_errno));
                 return -1;                        //否则表示发生了错误，返回-1
             }
         }
         else if(read_once == 0)
         {
-            /*一般情况下，recv返回0是由于客户端关闭连接导致的*/
+            /*一般情况下，readv返回0是由于客户端关闭连接导致的*/
             ::GetLogger()->debug("clinet {} has close the connection", fd);
             disconnect = true;
             break;
         }
         read_sum +=read_once;
-        buffer += std::string(std::begin(temp),std::begin(temp)+read_once);  //拼接数据
     }
 
     return read_sum;
@@ -266,47 +315,39 @@ ssize_t WriteData(int fd, const char* source, size_t n)
     return write_sum;
 }
 
-ssize_t WriteData(int fd, std::string& buffer, bool& full)
+ssize_t WriteData(int fd, OutputQueue& queue, bool& full)
 {
-    if(buffer.empty()) return 0;
-
     full = false;
-    auto num = buffer.size() + 1;      //期望写出的字节数
     ssize_t write_once = 0;            //本次写出的字节数
     ssize_t write_sum = 0;             //写出的总字节数
-    const char* ptr = buffer.c_str();  //转换后的字符串结尾多了一个\0，所以length要加一，否则会乱码
-    while(num > 0)
+    int saved_errno = 0;
+    while(!queue.Empty())
     {
-        write_once = send(fd, ptr, num, 0);
+        write_once = queue.WriteFd(fd, &saved_errno);   //已经写出的数据会从queue中删除
         if(write_once < 0)
         {
 
-            if(errno == EINTR) continue;  //被系统中断打断时重新再写一次
+            if(saved_errno == EINTR) continue;  //被系统中断打断时重新再写一次
             /*!
-             使用send函数且是非阻塞socket的情况下，一开始不需要注册EPOLLOUT，直接往socket写数据即可。
+             非阻塞socket的情况下，一开始不需要注册EPOLLOUT，直接往socket写数据即可。
              当errno == EAGAIN || errno==EWOULDBLOCK时表示发送缓冲区已经写满了。此时，若数据还没有
              发送完，就需要注册EPOLLOUT，然后通过回调函数在可以往发送区中继续写数据时发送剩余的数据。
              数据发送完后，需取消EPOLLOUT并重新注册EPOLLIN。
              */
-            else if(errno == EAGAIN || errno==EWOULDBLOCK)
+            else if(saved_errno == EAGAIN || saved_errno == EWOULDBLOCK)
             {
                 full = true;             //发送缓冲区已经写满了，返回
                 return write_sum;
             }
             else
             {
-                ::GetLogger()->error("write data to socket {} error: {}", fd, strerror(errno));
+                ::GetLogger()->error("write data to socket {} error: {}", fd, strerror(saved_errno));
                 return -1;                                                    //否则表示发生了错误，返回-1
             }
         }
-        num-=write_once;
         write_sum+=write_once;
-        ptr+=write_once;
     }
-    /*从buffer中删除已经写出的数据*/
-    if(write_sum == buffer.size() + 1) buffer.clear();
-    else buffer = buffer.substr(write_sum);
-    
+
     return write_sum;
 }
 
@@ -345,6 +386,7 @@ ThreadPool::~ThreadPool()
         std::unique_lock<std::mutex> locker(mutex_);
         stop_ = true;
     }
+    cond_.notify_all();      //唤醒所有休眠的线程，否则join会一直阻塞
     for (auto& item : workers_) item.join();
 }
 
@@ -365,7 +407,7 @@ std::shared_ptr<spdlog::logger> GetLogger(std::string path /*../temp/log.txt*/)
 
 std::optional<std::tuple<int,size_t ,std::string>> ParaseCommand(int argc,char* argv[])
 {
-    const char* str = "p:s:l:";
+    const char* str = "p:s:l:c:rb:w:e:t:";
     int res,port,subreactor_num;
     std::string log_file_path;
     while((res = getopt(argc,argv,str)) != -1)
@@ -389,6 +431,44 @@ std::optional<std::tuple<int,size_t ,std::string>> ParaseCommand(int argc,char*
                 }
                 log_file_path = results[0];
             }break;
+            case 'c':
+                GlobalVar::static_cache_budget_ = static_cast<size_t>(atol(optarg)) * 1024 * 1024;
+                break;
+            case 'r':
+                GlobalVar::reuse_port_ = true;
+                break;
+            case 'b':{
+                auto policy = ParseBalancePolicy(optarg);
+                if(!policy)
+                {
+                    printf("illegal balance policy\n");
+                    return std::nullopt;
+                }
+                GlobalVar::balance_policy_ = *policy;
+            }break;
+            case 'e':{
+                auto backend = ParsePollerBackend(optarg);
+                if(!backend)
+                {
+                    printf("illegal poller backend\n");
+                    return std::nullopt;
+                }
+                GlobalVar::poller_backend_ = *backend;
+            }break;
+            case 't':{
+                long interval = atol(optarg);
+                if(interval <= 0)
+                {
+                    printf("illegal tick interval\n");
+                    return std::nullopt;
+                }
+                GlobalVar::slot_interval_ = std::chrono::milliseconds(interval);
+            }break;
+            case 'w':
+                GlobalVar::object_pool_warm_ = static_cast<size_t>(atol(optarg));
+                GlobalVar::object_pool_low_ = std::max(GlobalVar::object_pool_low_, GlobalVar::object_pool_warm_);
+                GlobalVar::object_pool_high_ = std::max(GlobalVar::object_pool_high_, GlobalVar::object_pool_low_ * 4);
+                break;
             default:
                 break;
         }
@@ -1,6 +1,7 @@
 /*Linux System APIs*/
 #include <getopt.h>
 #include <libgen.h>
+#include <signal.h>
 
 /*STD Headers*/
 #include <chrono>
@@ -30,16 +31,6 @@ static void SigThread(void* arg)
             ::GetLogger()->error("sigwait error: {}", strerror(ret));
             exit(EXIT_FAILURE);
         }
-        /*SIGALRM信号处理*/
-        else if(sig == SIGALRM)
-        {
-            const char* msg = "Tick";
-            for (auto& tick_fd : server->tickfds_)
-            {
-                WriteData(tick_fd,msg, strlen(msg));
-            }
-            alarm(std::chrono::duration_cast<std::chrono::seconds>(GlobalVar::slot_interval_).count());
-        }
         /*SIGTREM信号处理*/
         else if(sig == SIGTERM)
         {
@@ -63,7 +54,7 @@ int main(int argc,char* argv[])
     if(!res)
     {
     	printf("command error\n");
-        printf("usage: %s [-p port_number] [-s subreactor_number ] [-l log_file_path(start with .)]",basename(argv[0]));
+        printf("usage: %s [-p port_number] [-s subreactor_number ] [-l log_file_path(start with .)] [-c static_cache_MB(0 to disable)] [-r(SO_REUSEPORT)] [-b least_conn|round_robin|p2c|ip_hash|least_busy] [-w object_pool_warm_size] [-e epoll|io_uring] [-t tick_interval_ms]",basename(argv[0]));
         return -1;
     }
 
@@ -81,7 +72,6 @@ int main(int argc,char* argv[])
      */
     sigset_t sigset;
     sigemptyset(&sigset);
-    sigaddset(&sigset,SIGALRM);
     sigaddset(&sigset,SIGTERM);
     sigaddset(&sigset,SIGPIPE);
     if(pthread_sigmask(SIG_BLOCK, &sigset,nullptr) != 0)
@@ -101,7 +91,6 @@ int main(int argc,char* argv[])
 
     /*服务器开始运行*/
     server->Start();
-    alarm(std::chrono::duration_cast<std::chrono::seconds>(GlobalVar::slot_interval_).count());
     main_reactor.StartLoop();
     return 0;
 }
@@ -0,0 +1,150 @@
+/*！
+@Author: DJJ
+@Description: 请求报文解析的性能测试，对比基于正则表达式的旧解析方式与HttpRequestParser，
+  以及HttpRequestParser在不同字符扫描实现(scalar/sse4.2/avx2)下的表现。
+
+  编译：g++ -std=c++17 -O2 -I../include ParserBenchmark.cpp ../src/HttpParser.cpp ../src/HttpHeaders.cpp ../src/CharScanner.cpp -o ParserBenchmark
+  运行：./ParserBenchmark [iterations]
+@Date: 2026/10/18 上午11:03
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "HttpParser.h"
+#include "CharScanner.h"
+
+/*!
+@brief 旧的解析方式：逐行substr，使用正则表达式匹配，并将结果保存到std::map中。
+*/
+static bool RegexParse(std::string buffer, std::map<std::string,std::string>& fields_values)
+{
+    auto pos = buffer.find("\r\n");
+    if(pos == std::string::npos) return false;
+    auto request_line = buffer.substr(0,pos);
+    buffer.erase(0,pos);
+
+    std::regex r(R"(^(GET|HEAD|POST)\s(\S*)\s(HTTP\/1\.[0|1])$)");
+    std::smatch results;
+    std::regex_match(request_line,results,r);
+    if(results.empty()) return false;
+    fields_values["method"] = results[1];
+    fields_values["URI"] = results[2];
+    fields_values["version"] = results[3];
+
+    auto FormatCheck = [&fields_values](std::string& target) -> bool
+    {
+        std::regex r(R"(^([[:alpha:]]\S*)\:\s(.+)$)");
+        std::smatch results;
+        std::regex_match(target,results,r);
+        if(results.empty()) return false;
+        fields_values[results[1]] = results[2];
+        return true;
+    };
+
+    decltype(buffer.size()) pos_cr = 0,old_pos = 0;
+    while(true)
+    {
+        old_pos = pos_cr;
+        pos_cr = buffer.find("\r\n",pos_cr + 2);
+        if(pos_cr == std::string::npos) return false;
+        else if(pos_cr == old_pos + 2) break;
+        std::string header_line = buffer.substr(old_pos+2,pos_cr-old_pos-2);
+        if(!FormatCheck(header_line)) return false;
+    }
+    return true;
+}
+
+/*!
+@brief 新的解析方式。
+*/
+static bool ParserParse(HttpRequestParser& parser, const std::string& buffer)
+{
+    parser.Reset();
+    if(parser.ParseRequestLine(buffer.data(), buffer.size()) != RequestLineParseState::kParseSuccess) return false;
+    return parser.ParseHeaderLines(buffer.data(), buffer.size()) == HeaderLinesParseState::kParseSuccess;
+}
+
+/*!
+@brief 模拟数据分多次到达的情况，每次多收到step个字节。
+*/
+static bool ParserParseIncremental(HttpRequestParser& parser, const std::string& buffer, size_t step)
+{
+    parser.Reset();
+    bool request_line_ok = false;
+    for (size_t len = step; ; len += step)
+    {
+        if(len > buffer.size()) len = buffer.size();
+        if(!request_line_ok)
+        {
+            auto ret = parser.ParseRequestLine(buffer.data(), len);
+            if(ret == RequestLineParseState::kParseError) return false;
+            if(ret == RequestLineParseState::kParseAgain) continue;
+            request_line_ok = true;
+        }
+        auto ret = parser.ParseHeaderLines(buffer.data(), len);
+        if(ret != HeaderLinesParseState::kParseAgain) return ret == HeaderLinesParseState::kParseSuccess;
+        if(len == buffer.size()) return false;
+    }
+}
+
+template<typename F>
+static void Run(const char* name, size_t iterations, size_t bytes, F&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        if(!func())
+        {
+            printf("%s: parse failed\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    double per_request = static_cast<double>(ns) / iterations;
+    printf("  %-30s %10.1f ns/request %10.1f MB/s\n", name, per_request, bytes / per_request * 1e3);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::vector<std::pair<const char*, std::string>> requests;
+    requests.emplace_back("minimal", "GET /hello HTTP/1.1\r\nConnection: keep-alive\r\n\r\n");
+    requests.emplace_back("browser",
+                          "GET /index.html HTTP/1.1\r\n"
+                          "Host: localhost:8080\r\n"
+                          "Connection: keep-alive\r\n"
+                          "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/96.0 Safari/537.36\r\n"
+                          "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,*/*;q=0.8\r\n"
+                          "Accept-Encoding: gzip, deflate, br\r\n"
+                          "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+                          "If-None-Match: \"5f1e9a3c-4\"\r\n"
+                          "If-Modified-Since: Sat, 12 Jun 2021 09:34:00 GMT\r\n"
+                          "\r\n");
+    std::string cookie = "GET /index.html HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\nCookie: ";
+    for (int i = 0; i < 64; ++i) cookie += "session_key_" + std::to_string(i) + "=0123456789abcdef0123456789abcdef; ";
+    cookie += "end=1\r\n\r\n";
+    requests.emplace_back("large cookie", cookie);
+
+    HttpRequestParser parser;
+    for (const auto& [name, request] : requests)
+    {
+        printf("%s (%zu bytes)\n", name, request.size());
+        std::map<std::string,std::string> fields_values;
+        Run("regex", iterations / 10, request.size(), [&]{fields_values.clear(); return RegexParse(request, fields_values);});
+        for (auto scanner : {"scalar", "sse4.2", "avx2"})
+        {
+            if(!SelectCharScanner(scanner)) continue;
+            std::string whole = std::string("parser ") + scanner;
+            std::string chunked = whole + " (16B chunks)";
+            Run(whole.c_str(), iterations, request.size(), [&]{return ParserParse(parser, request);});
+            Run(chunked.c_str(), iterations, request.size(), [&]{return ParserParseIncremental(parser, request, 16);});
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+/*！
+@Author: DJJ
+@Description: 时间轮的性能测试，对比旧的单层时间轮(每个槽一个std::list，删除和调整需要list::remove)与
+  分层时间轮(侵入式链表)在大量定时器下加入、调整、延后(RefreshTimer)、删除和转动的开销，同时检查每个
+  定时器都在预期的tick触发；最后模拟大量连接同时超时，检查按预算分批触发时每批不超过预算且全部触发。
+
+  编译：g++ -std=c++17 -O2 -I../include TimerBenchmark.cpp ../src/Timer.cpp -o TimerBenchmark
+  运行：./TimerBenchmark [timer_num]
+@Date: 2026/10/26 下午4:10
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Timer.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double NsPerOp(Clock::time_point start, size_t ops)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    return ops ? static_cast<double>(ns) / ops : 0.0;
+}
+
+/*!
+@brief 旧的单层时间轮：60个槽，每个槽一个std::list<Timer*>，超过一圈的定时器记录剩余圈数。
+*/
+class LegacyWheel{
+public:
+    struct LegacyTimer{
+        size_t cycles = 0;
+        size_t slot = 0;
+        bool pending = false;
+    };
+private:
+    std::vector<std::list<LegacyTimer*>> slots_;
+    size_t current_slot_ = 0;
+public:
+    explicit LegacyWheel(size_t slot_num) : slots_(slot_num) {}
+
+    void Add(LegacyTimer* timer, size_t ticks)
+    {
+        timer->cycles = ticks / slots_.size();
+        timer->slot = (current_slot_ + ticks % slots_.size()) % slots_.size();
+        timer->pending = true;
+        slots_[timer->slot].push_back(timer);
+    }
+
+    void Adjust(LegacyTimer* timer, size_t ticks)
+    {
+        slots_[timer->slot].remove(timer);
+        Add(timer, ticks);
+    }
+
+    void Del(LegacyTimer* timer)
+    {
+        slots_[timer->slot].remove(timer);
+        timer->pending = false;
+    }
+
+    size_t Tick()
+    {
+        size_t expired = 0;
+        auto& slot = slots_[current_slot_];
+        for (auto it = slot.begin(); it != slot.end();)
+        {
+            if((*it)->cycles > 0)
+            {
+                --(*it)->cycles;
+                ++it;
+            }
+            else
+            {
+                (*it)->pending = false;
+                it = slot.erase(it);
+                ++expired;
+            }
+        }
+        current_slot_ = (current_slot_ + 1) % slots_.size();
+        return expired;
+    }
+};
+
+/*!
+@brief 模拟一个连接：定时器嵌入在对象中，超时时记录触发时的tick。
+*/
+struct Connection{
+    Timer timer;
+    uint64_t fired_tick = 0;
+};
+
+int main(int argc, char* argv[])
+{
+    size_t timer_num = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 1000000;
+    const uint64_t kTimeoutTicks = 60000;             //1毫秒一个tick时的60秒
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> timeout_dist(1, kTimeoutTicks);
+    std::uniform_int_distribution<size_t> index_dist(0, timer_num - 1);
+
+    /*----------------------------分层时间轮----------------------------*/
+    printf("hierarchical wheel, %zu timers, timeouts in [1, %llu] ticks\n", timer_num, (unsigned long long)kTimeoutTicks);
+    TimeWheel wheel(std::chrono::milliseconds(1));
+    std::vector<std::unique_ptr<Connection>> conns;
+    conns.reserve(timer_num);
+    for (size_t i = 0; i < timer_num; ++i)
+    {
+        auto conn = std::make_unique<Connection>();
+        Connection* raw = conn.get();
+        conn->timer.SetExpiredHandler([raw, &wheel](){raw->fired_tick = wheel.GetCurrentTick();});
+        conns.push_back(std::move(conn));
+    }
+
+    auto start = Clock::now();
+    for (auto& conn : conns) wheel.AddTimer(&conn->timer, std::chrono::milliseconds(timeout_dist(rng)));
+    printf("  %-24s %8.1f ns/op\n", "add", NsPerOp(start, timer_num));
+
+    /*每个长连接请求都会重新设置超时时间*/
+    start = Clock::now();
+    for (size_t i = 0; i < timer_num; ++i)
+    {
+        wheel.AddTimer(&conns[index_dist(rng)]->timer, std::chrono::milliseconds(timeout_dist(rng)));
+    }
+    printf("  %-24s %8.1f ns/op\n", "reschedule", NsPerOp(start, timer_num));
+
+    /*RefreshTimer延后到期时间时只记录到期tick，不移动定时器*/
+    start = Clock::now();
+    for (size_t i = 0; i < timer_num; ++i)
+    {
+        wheel.RefreshTimer(&conns[index_dist(rng)]->timer, std::chrono::milliseconds(kTimeoutTicks));
+    }
+    printf("  %-24s %8.1f ns/op\n", "refresh (lazy)", NsPerOp(start, timer_num));
+
+    start = Clock::now();
+    size_t deleted = 0;
+    for (size_t i = 0; i < timer_num; i += 2)
+    {
+        wheel.DelTimer(&conns[i]->timer);
+        ++deleted;
+    }
+    printf("  %-24s %8.1f ns/op\n", "cancel", NsPerOp(start, deleted));
+
+    std::vector<uint64_t> expected(timer_num, 0);
+    for (size_t i = 0; i < timer_num; ++i)
+    {
+        if(conns[i]->timer.IsPending()) expected[i] = conns[i]->timer.GetExpireTick();
+    }
+    size_t pending = wheel.Size();
+    start = Clock::now();
+    for (uint64_t i = 0; i <= kTimeoutTicks + 1; ++i) wheel.Tick();
+    printf("  %-24s %8.1f ns/tick (%zu timers expired)\n", "tick", NsPerOp(start, kTimeoutTicks + 2), pending - wheel.Size());
+
+    size_t wrong = 0;
+    for (size_t i = 0; i < timer_num; ++i)
+    {
+        if(conns[i]->fired_tick != expected[i]) ++wrong;
+    }
+    printf("  %-24s %zu timers left, %zu fired at the wrong tick\n", "check", wheel.Size(), wrong);
+
+    /*----------------------------同时超时的连接按预算分批触发----------------------------*/
+    const size_t kBudget = 256;
+    TimeWheel budget_wheel(std::chrono::milliseconds(1), kBudget);
+    size_t storm_fired = 0;
+    for (auto& conn : conns)
+    {
+        conn->timer.SetExpiredHandler([&storm_fired](){++storm_fired;});
+        budget_wheel.AddTimer(&conn->timer, std::chrono::milliseconds(1000));
+    }
+    while(!budget_wheel.HasOverdue()) budget_wheel.Advance();
+    size_t batches = 0, max_batch = 0;
+    start = Clock::now();
+    while(budget_wheel.HasOverdue())
+    {
+        max_batch = std::max(max_batch, budget_wheel.ExpireOverdue());
+        ++batches;
+    }
+    printf("  %-24s %8.1f ns/timer, %zu batches (max %zu, budget %zu), %zu fired, %zu left\n", "expire storm",
+           NsPerOp(start, timer_num), batches, max_batch, kBudget, storm_fired, budget_wheel.Size());
+
+    /*定时器在时间轮中时析构，时间轮的定时器数量也要减少*/
+    {
+        std::vector<Timer> dropped(1000);
+        for (auto& timer : dropped) budget_wheel.AddTimer(&timer, std::chrono::milliseconds(1000));
+    }
+    printf("  %-24s %zu timers left after destroying pending timers\n", "destroy", budget_wheel.Size());
+
+    /*----------------------------旧的单层时间轮----------------------------*/
+    /*list::remove是O(槽中定时器数量)，调整和删除只测一小部分，否则要运行很久*/
+    size_t legacy_ops = std::min<size_t>(timer_num, 10000);
+    printf("legacy wheel (60 slots, std::list), %zu timers, %zu adjust/cancel ops\n", timer_num, legacy_ops);
+    LegacyWheel legacy(60);
+    std::vector<LegacyWheel::LegacyTimer> legacy_timers(timer_num);
+    std::uniform_int_distribution<size_t> legacy_timeout_dist(1, 60);   //1秒一个tick时的60秒
+
+    start = Clock::now();
+    for (auto& timer : legacy_timers) legacy.Add(&timer, legacy_timeout_dist(rng));
+    printf("  %-24s %8.1f ns/op\n", "add", NsPerOp(start, timer_num));
+
+    start = Clock::now();
+    for (size_t i = 0; i < legacy_ops; ++i) legacy.Adjust(&legacy_timers[index_dist(rng)], legacy_timeout_dist(rng));
+    printf("  %-24s %8.1f ns/op\n", "reschedule", NsPerOp(start, legacy_ops));
+
+    start = Clock::now();
+    for (size_t i = 0; i < legacy_ops; ++i) legacy.Del(&legacy_timers[i]);
+    printf("  %-24s %8.1f ns/op\n", "cancel", NsPerOp(start, legacy_ops));
+
+    start = Clock::now();
+    size_t expired = 0;
+    for (int i = 0; i < 60; ++i) expired += legacy.Tick();
+    printf("  %-24s %8.1f ns/tick (%zu timers expired)\n", "tick", NsPerOp(start, 60), expired);
+    return 0;
+}